@@ -0,0 +1,127 @@
+// replays an MBO csv through Orderbook and reports per-action latency.
+// built once per BookSide backend (book_bench_map, book_bench_ladder, book_bench_vector),
+// run each binary on the same file to compare, e.g. ./book_bench_vector es0604.csv
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "orderbook.h"
+#include "parser.h"
+
+namespace {
+
+constexpr const char *backend_name() {
+    switch (ORDERBOOK_BOOK_BACKEND) {
+        case BookBackend::Map:
+            return "map";
+        case BookBackend::Ladder:
+            return "ladder";
+        case BookBackend::Vector:
+            return "vector";
+    }
+    return "unknown";
+}
+
+int action_index(char action) {
+    switch (action) {
+        case 'A':
+            return 0;
+        case 'C':
+            return 1;
+        case 'M':
+            return 2;
+        case 'T':
+            return 3;
+        default:
+            return 4;
+    }
+}
+
+uint64_t percentile(std::vector<uint32_t> &samples, double pct) {
+    if (samples.empty()) {
+        return 0;
+    }
+    size_t idx = static_cast<size_t>(pct * static_cast<double>(samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+    return samples[idx];
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const char *file_path = argc > 1 ? argv[1] : "es0604.csv";
+
+    Parser parser(file_path);
+    parser.parse();
+    const auto &messages = parser.message_stream_;
+    if (messages.empty()) {
+        std::fprintf(stderr, "no messages parsed from %s\n", file_path);
+        return 1;
+    }
+
+    DatabaseManager db_manager("127.0.0.1", 9009);
+    Orderbook book(db_manager);
+
+    constexpr std::array<char, 5> actions = {'A', 'C', 'M', 'T', '?'};
+    std::array<std::vector<uint32_t>, 5> latencies;
+    for (auto &samples: latencies) {
+        samples.reserve(messages.size() / 2);
+    }
+
+    auto replay_start = std::chrono::steady_clock::now();
+    for (const auto &msg: messages) {
+        auto start = std::chrono::steady_clock::now();
+        book.process_msg(msg);
+        auto end = std::chrono::steady_clock::now();
+        latencies[action_index(msg.action_)].push_back(
+                static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+    }
+    auto replay_end = std::chrono::steady_clock::now();
+    double total_s = std::chrono::duration<double>(replay_end - replay_start).count();
+
+    std::printf("backend: %s, file: %s, messages: %zu\n", backend_name(), file_path, messages.size());
+    std::printf("replay: %.3f s, %.2f M msg/s (timer overhead included)\n",
+                total_s, static_cast<double>(messages.size()) / total_s / 1e6);
+    std::printf("%-6s %10s %10s %8s %8s %8s %8s\n", "action", "count", "mean_ns", "p50", "p90", "p99", "p99.9");
+
+    for (size_t i = 0; i < actions.size(); ++i) {
+        auto &samples = latencies[i];
+        if (samples.empty()) {
+            continue;
+        }
+        uint64_t sum = 0;
+        for (auto ns: samples) {
+            sum += ns;
+        }
+        double mean = static_cast<double>(sum) / static_cast<double>(samples.size());
+        std::printf("%-6c %10zu %10.1f %8llu %8llu %8llu %8llu\n", actions[i], samples.size(), mean,
+                    static_cast<unsigned long long>(percentile(samples, 0.50)),
+                    static_cast<unsigned long long>(percentile(samples, 0.90)),
+                    static_cast<unsigned long long>(percentile(samples, 0.99)),
+                    static_cast<unsigned long long>(percentile(samples, 0.999)));
+    }
+
+    // untimed per message loop against process_batch, which prefetches ahead of the current message
+    Orderbook single(db_manager);
+    auto single_start = std::chrono::steady_clock::now();
+    for (const auto &msg: messages) {
+        single.process_msg(msg);
+    }
+    double single_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - single_start).count();
+
+    Orderbook batched(db_manager);
+    auto batch_start = std::chrono::steady_clock::now();
+    batched.process_batch(messages.data(), messages.size());
+    double batch_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - batch_start).count();
+
+    bool same = single.get_bbo() == batched.get_bbo() && single.get_count() == batched.get_count() &&
+                single.bid_vol_ == batched.bid_vol_ && single.ask_vol_ == batched.ask_vol_ &&
+                single.vwap_ == batched.vwap_ && single.bids_.size() == batched.bids_.size() &&
+                single.offers_.size() == batched.offers_.size();
+    std::printf("process_msg: %.1f ns/msg, process_batch: %.1f ns/msg, %s\n",
+                single_s * 1e9 / static_cast<double>(messages.size()),
+                batch_s * 1e9 / static_cast<double>(messages.size()), same ? "same book" : "MISMATCH");
+
+    return same ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+// multi-instrument replay through BookManager with 1..max_shards workers on a synthetic,
+// interleaved MBO stream. every run is checked against a single-threaded replay with one
+// Orderbook per instrument through a consistent snapshot taken at the end of the stream, and
+// the snapshots taken along the way must each catch every book between two exchange events.
+// usage: ./book_manager_bench [instruments] [messages_per_instrument] [max_shards]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "book_manager.h"
+
+namespace {
+
+struct LiveOrder {
+    uint64_t id;
+    int32_t price;
+    uint32_t size;
+    bool side;
+};
+
+// random but valid add/cancel/modify flow around a drifting mid, one instrument per slot. about
+// half the messages leave their instrument's event open, each instrument's last one closes it
+std::vector<message> generate(uint32_t instruments, size_t per_instrument) {
+    std::mt19937_64 rng(7);
+    std::vector<std::vector<LiveOrder>> live(instruments);
+    std::vector<int32_t> mid(instruments);
+    std::vector<uint64_t> next_id(instruments, 1);
+    for (uint32_t i = 0; i < instruments; ++i) {
+        mid[i] = 400000 + static_cast<int32_t>(i) * 1000;
+    }
+
+    std::vector<message> messages;
+    messages.reserve(static_cast<size_t>(instruments) * per_instrument);
+    for (size_t n = 0; n < static_cast<size_t>(instruments) * per_instrument; ++n) {
+        uint32_t inst = static_cast<uint32_t>(rng() % instruments);
+        auto &orders = live[inst];
+        uint64_t ts = 1717407000000000000ull + n * 1000;
+        uint8_t flags = rng() & 1 ? message::F_LAST : 0;
+        if (rng() % 500 == 0) {
+            mid[inst] += static_cast<int32_t>(rng() % 9) - 4;
+        }
+        int action = static_cast<int>(rng() % 100);
+        if (orders.empty() || action < 45) {
+            bool side = rng() & 1;
+            int32_t offset = 1 + static_cast<int32_t>(rng() % 40);
+            LiveOrder order{next_id[inst]++, side ? mid[inst] - offset : mid[inst] + offset,
+                            1 + static_cast<uint32_t>(rng() % 20), side};
+            messages.emplace_back(order.id, ts, order.size, order.price, 'A', order.side, inst, flags);
+            orders.push_back(order);
+        } else if (action < 80) {
+            size_t k = rng() % orders.size();
+            const LiveOrder &order = orders[k];
+            messages.emplace_back(order.id, ts, order.size, order.price, 'C', order.side, inst, flags);
+            orders[k] = orders.back();
+            orders.pop_back();
+        } else {
+            LiveOrder &order = orders[rng() % orders.size()];
+            order.size = 1 + static_cast<uint32_t>(rng() % 20);
+            messages.emplace_back(order.id, ts, order.size, order.price, 'M', order.side, inst, flags);
+        }
+    }
+    std::vector<bool> closed(instruments, false);
+    for (auto it = messages.rbegin(); it != messages.rend(); ++it) {
+        if (!closed[it->instrument_id_]) {
+            closed[it->instrument_id_] = true;
+            it->flags_ |= message::F_LAST;
+        }
+    }
+    return messages;
+}
+
+// event_ends[i][k]: instrument i's book is between events after its first k messages
+std::vector<std::vector<bool>> event_ends(const std::vector<message> &messages, uint32_t instruments) {
+    std::vector<std::vector<bool>> ends(instruments, std::vector<bool>{true});
+    for (const auto &msg: messages) {
+        ends[msg.instrument_id_].push_back(msg.is_last());
+    }
+    return ends;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const uint32_t instruments = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 16;
+    const size_t per_instrument = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 500000;
+    const size_t max_shards = argc > 3 ? std::strtoul(argv[3], nullptr, 10)
+                                       : std::max(1u, std::thread::hardware_concurrency() - 1);
+
+    std::vector<message> messages = generate(instruments, per_instrument);
+    std::vector<std::vector<bool>> ends = event_ends(messages, instruments);
+    DatabaseManager db_manager("127.0.0.1", 9009);
+
+    // reference: one thread, one book per instrument
+    std::unordered_map<uint32_t, std::unique_ptr<Orderbook>> reference;
+    for (uint32_t i = 0; i < instruments; ++i) {
+        reference.emplace(i, std::make_unique<Orderbook>(db_manager, 1 << 16));
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &msg: messages) {
+        reference[msg.instrument_id_]->process_msg(msg);
+    }
+    double single_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double single_rate = static_cast<double>(messages.size()) / single_s;
+
+    std::printf("instruments: %u, messages: %zu\n", instruments, messages.size());
+    std::printf("%-10s %12s %12s %10s %8s\n", "shards", "seconds", "M msg/s", "speedup", "check");
+    std::printf("%-10s %12.3f %12.2f %10.2f %8s\n", "unsharded", single_s, single_rate / 1e6, 1.0, "-");
+
+    for (size_t shards = 1; shards <= max_shards; shards *= 2) {
+        BookManager manager(db_manager, shards);
+        manager.start();
+        start = std::chrono::steady_clock::now();
+        // markers at arbitrary stream positions, most of them inside some instrument's event
+        constexpr size_t MID_SNAPSHOTS = 64;
+        std::vector<uint64_t> tickets;
+        for (size_t k = 0; k < MID_SNAPSHOTS; ++k) {
+            size_t from = messages.size() * k / MID_SNAPSHOTS;
+            size_t to = messages.size() * (k + 1) / MID_SNAPSHOTS;
+            manager.submit(messages.data() + from, to - from);
+            if (k + 1 < MID_SNAPSHOTS) {
+                tickets.push_back(manager.request_snapshot());
+            }
+        }
+        BookSnapshot snapshot = manager.wait_snapshot(manager.request_snapshot());
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        bool ok = true;
+        for (uint64_t ticket: tickets) {
+            BookSnapshot mid = manager.wait_snapshot(ticket);
+            for (const auto &inst: mid.instruments_) {
+                ok = ok && ends[inst.instrument_id_][inst.message_count_];
+            }
+        }
+        manager.stop();
+
+        ok = ok && snapshot.sequence_ == messages.size() && snapshot.instruments_.size() == instruments;
+        for (const auto &inst: snapshot.instruments_) {
+            ok = ok && inst.bbo_ == reference[inst.instrument_id_]->get_bbo() &&
+                 inst.bid_vol_ == reference[inst.instrument_id_]->bid_vol_ &&
+                 inst.ask_vol_ == reference[inst.instrument_id_]->ask_vol_;
+        }
+        double rate = static_cast<double>(messages.size()) / seconds;
+        std::printf("%-10zu %12.3f %12.2f %10.2f %8s\n", shards, seconds, rate / 1e6, rate / single_rate,
+                    ok ? "ok" : "MISMATCH");
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+// parses a csv with every separator scan backend this cpu supports and with the previous
+// strchr/strtoull line parser, then with the default backend on 2, 4, ... threads. checks each
+// result message for message against the old parser.
+// usage: ./csv_parse_bench es0604.csv [runs] [max threads]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <thread>
+#include <vector>
+#include "parser.h"
+
+namespace {
+
+// the parser before the block tokenizer, kept as the reference. it relies on the mapping
+// having a byte past every comma it looks for, which holds for these files
+void legacy_parse_line(const char *start, const char *end, std::vector<message> &out) {
+    const char *token_start = start;
+    const char *token_end = strchr(token_start, ',');
+    uint64_t ts_event = strtoull(token_start, nullptr, 10);
+    token_start = token_end + 1;
+    char action = *token_start;
+    token_start = strchr(token_start, ',') + 1;
+    char side = *token_start;
+    token_start = strchr(token_start, ',') + 1;
+    token_end = strchr(token_start, ',');
+    int32_t price = strtol(token_start, nullptr, 10);
+    token_start = token_end + 1;
+    token_end = strchr(token_start, ',');
+    uint32_t size = strtoul(token_start, nullptr, 10);
+    token_start = token_end + 1;
+    uint64_t order_id = strtoull(token_start, nullptr, 10);
+
+    uint8_t flags = message::F_LAST;
+    uint32_t sequence = 0;
+    const char *flags_start = static_cast<const char *>(memchr(token_start, ',', end - token_start));
+    if (flags_start) {
+        flags = static_cast<uint8_t>(strtoul(flags_start + 1, nullptr, 10));
+        const char *delta_start = static_cast<const char *>(memchr(flags_start + 1, ',', end - flags_start - 1));
+        const char *sequence_start = delta_start
+                ? static_cast<const char *>(memchr(delta_start + 1, ',', end - delta_start - 1)) : nullptr;
+        if (sequence_start) {
+            sequence = static_cast<uint32_t>(strtoul(sequence_start + 1, nullptr, 10));
+        }
+    }
+    out.emplace_back(order_id, ts_event, size, price, action, side == 'B', 0, flags, sequence);
+}
+
+std::vector<message> legacy_parse(const std::string &file_path) {
+    std::vector<message> out;
+    int fd = open(file_path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return out;
+    }
+    struct stat sb;
+    fstat(fd, &sb);
+    size_t size = sb.st_size;
+    char *mapped = static_cast<char *>(mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0));
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return out;
+    }
+    out.reserve(9000000);
+    const char *current = mapped;
+    const char *end = mapped + size;
+    for (int i = 0; i < 2 && current < end; ++i) {
+        current = static_cast<const char *>(memchr(current, '\n', end - current)) + 1;
+    }
+    while (current < end) {
+        const char *line_end = static_cast<const char *>(memchr(current, '\n', end - current));
+        if (!line_end) line_end = end;
+        legacy_parse_line(current, line_end, out);
+        current = line_end + 1;
+    }
+    munmap(mapped, size);
+    return out;
+}
+
+bool same(const message &a, const message &b) {
+    return a.id_ == b.id_ && a.time_ == b.time_ && a.size_ == b.size_ && a.price_ == b.price_ &&
+           a.action_ == b.action_ && a.side_ == b.side_ && a.flags_ == b.flags_ && a.sequence_ == b.sequence_;
+}
+
+template<typename F>
+double best_seconds(int runs, F &&f) {
+    double best = 0.0;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = i == 0 || seconds < best ? seconds : best;
+    }
+    return best;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const std::string file_path = argc > 1 ? argv[1] : "es0604.csv";
+    const int runs = argc > 2 ? std::atoi(argv[2]) : 3;
+    const size_t max_threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10)
+                                        : std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<message> reference;
+    double legacy_s = best_seconds(runs, [&]() { reference = legacy_parse(file_path); });
+    if (reference.empty()) {
+        std::fprintf(stderr, "no messages parsed from %s\n", file_path.c_str());
+        return 1;
+    }
+    std::printf("%-10s %10zu msgs %8.3f s %8.1f ns/msg\n", "strtoull", reference.size(), legacy_s,
+                legacy_s * 1e9 / reference.size());
+
+    bool ok = true;
+    auto check = [&](const char *label, const CsvScanKernels &kernels, size_t threads) {
+        std::vector<message> messages;
+        double seconds = best_seconds(runs, [&]() {
+            Parser parser(file_path);
+            parser.set_scan_kernels(kernels);
+            parser.parse(threads);
+            messages = std::move(parser.message_stream_);
+        });
+        size_t mismatches = messages.size() == reference.size() ? 0 : 1;
+        for (size_t i = 0; i < messages.size() && i < reference.size(); ++i) {
+            mismatches += !same(messages[i], reference[i]);
+        }
+        ok = ok && mismatches == 0;
+        std::printf("%-10s %10zu msgs %8.3f s %8.1f ns/msg %6.2fx %s\n", label, messages.size(), seconds,
+                    seconds * 1e9 / messages.size(), legacy_s / seconds, mismatches == 0 ? "ok" : "MISMATCH");
+    };
+
+    for (SimdBackend backend: {SimdBackend::Scalar, SimdBackend::SSE42, SimdBackend::AVX2, SimdBackend::NEON}) {
+        if (const CsvScanKernels *kernels = csv_scan_kernels_for(backend)) {
+            check(kernels->name, *kernels, 1);
+        }
+    }
+    for (size_t threads = 2; threads <= max_threads; threads *= 2) {
+        std::string label = std::string(csv_scan_kernels().name) + " x" + std::to_string(threads);
+        check(label.c_str(), csv_scan_kernels(), threads);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+// decodes an uncompressed dbn mbo file in place, converts it to messages and replays it into a
+// book straight from the mapping. given the same day as csv, also times the csv parse and
+// checks the two message for message.
+// usage: ./dbn_bench es0604.dbn [es0604.csv] [runs]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "dbn.h"
+#include "orderbook.h"
+#include "parser.h"
+
+namespace {
+
+bool same(const message &a, const message &b) {
+    return a.id_ == b.id_ && a.time_ == b.time_ && a.size_ == b.size_ && a.price_ == b.price_ &&
+           a.action_ == b.action_ && a.side_ == b.side_ && a.flags_ == b.flags_ && a.sequence_ == b.sequence_;
+}
+
+template<typename F>
+double best_seconds(int runs, F &&f) {
+    double best = 0.0;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = i == 0 || seconds < best ? seconds : best;
+    }
+    return best;
+}
+
+void report(const char *label, size_t count, double seconds) {
+    std::printf("%-14s %10zu msgs %8.3f s %8.1f ns/msg\n", label, count, seconds,
+                count > 0 ? seconds * 1e9 / count : 0.0);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const std::string file_path = argc > 1 ? argv[1] : "es0604.dbn";
+    const char *csv_path = argc > 2 ? argv[2] : nullptr;
+    const int runs = argc > 3 ? std::atoi(argv[3]) : 3;
+
+    DbnFile file(file_path);
+    if (!file.is_open()) {
+        return 1;
+    }
+    std::printf("dbn v%d, dataset %s\n", file.version(), file.dataset().c_str());
+
+    size_t records = 0;
+    uint64_t checksum = 0;
+    double scan_s = best_seconds(runs, [&]() {
+        records = file.for_each_mbo([&](const DbnMboView &mbo) { checksum += mbo.order_id() ^ mbo.price(); });
+    });
+    report("scan", records, scan_s);
+    std::printf("checksum %016llx\n", static_cast<unsigned long long>(checksum));
+
+    std::vector<message> messages;
+    double convert_s = best_seconds(runs, [&]() { messages = file.to_messages(); });
+    report("to_messages", messages.size(), convert_s);
+
+    DatabaseManager db_manager("127.0.0.1", 9009);
+    double replay_s = best_seconds(runs, [&]() {
+        Orderbook book(db_manager);
+        file.replay(book);
+    });
+    report("replay", records, replay_s);
+
+    double vector_s = best_seconds(runs, [&]() {
+        Orderbook book(db_manager);
+        for (const auto &msg: messages) {
+            book.process_msg(msg);
+        }
+    });
+    report("vector replay", messages.size(), vector_s);
+
+    if (!csv_path) {
+        return 0;
+    }
+    std::vector<message> csv_messages;
+    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    double csv_s = best_seconds(runs, [&]() {
+        Parser parser(csv_path);
+        parser.parse(threads);
+        csv_messages = std::move(parser.message_stream_);
+    });
+    report("csv parse", csv_messages.size(), csv_s);
+
+    size_t mismatches = csv_messages.size() == messages.size() ? 0 : 1;
+    for (size_t i = 0; i < messages.size() && i < csv_messages.size(); ++i) {
+        mismatches += !same(messages[i], csv_messages[i]);
+    }
+    std::printf("csv vs dbn: %s, dbn decode %.2fx faster than the csv parse\n",
+                mismatches == 0 ? "ok" : "MISMATCH", convert_s > 0 ? csv_s / convert_s : 0.0);
+    return mismatches == 0 ? 0 : 1;
+}
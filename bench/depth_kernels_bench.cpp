@@ -0,0 +1,89 @@
+// times every depth kernel backend this cpu supports (scalar, sse4.2, avx2, neon) on random
+// level-volume arrays and checks each result against the scalar kernels.
+// usage: ./depth_kernels_bench [levels] [iterations]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <random>
+#include <vector>
+#include "depth_kernels.h"
+
+namespace {
+
+template<typename F>
+double time_ns(int iterations, F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        f();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const size_t levels = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    const int iterations = argc > 2 ? std::atoi(argv[2]) : 1000000;
+    if (levels == 0) {
+        std::fprintf(stderr, "need at least one level\n");
+        return 1;
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> volume(0, 500);
+    std::vector<uint32_t> bid(levels), ask(levels), bid_cum(levels), ask_cum(levels);
+    std::vector<double> weights(levels), out(levels), expected(levels);
+    for (size_t i = 0; i < levels; ++i) {
+        bid[i] = volume(rng);
+        ask[i] = volume(rng);
+        weights[i] = std::exp(-0.05 * static_cast<double>(i));
+    }
+
+    const DepthKernels &scalar = *depth_kernels_for(SimdBackend::Scalar);
+    double expected_sum = scalar.weighted_sum(bid.data(), weights.data(), levels);
+    scalar.cumulative(bid.data(), bid_cum.data(), levels);
+    scalar.cumulative(ask.data(), ask_cum.data(), levels);
+    scalar.imbalance(bid_cum.data(), ask_cum.data(), expected.data(), levels);
+    const std::vector<uint32_t> expected_cum = bid_cum;
+
+    std::printf("levels: %zu, iterations: %d, dispatched: %s\n", levels, iterations, depth_kernels().name);
+    std::printf("%-8s %14s %14s %14s %8s\n", "backend", "weighted_ns", "cumulative_ns", "imbalance_ns", "check");
+
+    double sink = 0.0;
+    for (SimdBackend backend: {SimdBackend::Scalar, SimdBackend::SSE42, SimdBackend::AVX2, SimdBackend::NEON}) {
+        const DepthKernels *kernels = depth_kernels_for(backend);
+        if (kernels == nullptr) {
+            continue;
+        }
+
+        double sum = kernels->weighted_sum(bid.data(), weights.data(), levels);
+        kernels->cumulative(bid.data(), bid_cum.data(), levels);
+        kernels->imbalance(expected_cum.data(), ask_cum.data(), out.data(), levels);
+        bool ok = std::abs(sum - expected_sum) <= 1e-9 * std::max(1.0, std::abs(expected_sum)) &&
+                  bid_cum == expected_cum;
+        for (size_t i = 0; i < levels; ++i) {
+            ok = ok && std::abs(out[i] - expected[i]) <= 1e-12;
+        }
+
+        double weighted_ns = time_ns(iterations, [&] {
+            sink += kernels->weighted_sum(bid.data(), weights.data(), levels);
+        });
+        double cumulative_ns = time_ns(iterations, [&] {
+            kernels->cumulative(bid.data(), bid_cum.data(), levels);
+            sink += bid_cum[levels - 1];
+        });
+        double imbalance_ns = time_ns(iterations, [&] {
+            kernels->imbalance(expected_cum.data(), ask_cum.data(), out.data(), levels);
+            sink += out[levels - 1];
+        });
+
+        std::printf("%-8s %14.2f %14.2f %14.2f %8s\n", kernels->name, weighted_ns, cumulative_ns, imbalance_ns,
+                    ok ? "ok" : "MISMATCH");
+    }
+    std::printf("(sink %g)\n", sink);
+    return 0;
+}
@@ -0,0 +1,69 @@
+// per-second feature extraction over one day with 1, 2, 4, ... threads. every multi-threaded
+// run is checked row by row against the single threaded replay.
+// usage: ./feature_replay_bench es0604.csv [max_threads] [index_dir]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "feature_replay.h"
+#include "parser.h"
+
+namespace {
+
+bool same_rows(const std::vector<SecondFeatures> &a, const std::vector<SecondFeatures> &b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].second_ != b[i].second_ || a[i].bbo_ != b[i].bbo_ || a[i].voi_ != b[i].voi_ ||
+            a[i].imbalance_ != b[i].imbalance_ || a[i].bid_vol_ != b[i].bid_vol_ ||
+            a[i].ask_vol_ != b[i].ask_vol_ || a[i].message_count_ != b[i].message_count_) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const char *file_path = argc > 1 ? argv[1] : "es0604.csv";
+    const size_t max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10)
+                                        : std::max(1u, std::thread::hardware_concurrency());
+    const std::string dir = argc > 3 ? argv[3] : "snapshots";
+
+    Parser parser(file_path);
+    parser.parse();
+    const auto &messages = parser.message_stream_;
+    if (messages.empty()) {
+        std::fprintf(stderr, "no messages parsed from %s\n", file_path);
+        return 1;
+    }
+    DatabaseManager db_manager("127.0.0.1", 9009);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SecondFeatures> reference = extract_second_features(db_manager, messages, dir, 1);
+    double serial_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // the first parallel run builds the snapshot index, time it separately
+    start = std::chrono::steady_clock::now();
+    bool ok = same_rows(extract_second_features(db_manager, messages, dir, 2), reference);
+    double first_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("messages: %zu, seconds: %zu\n", messages.size(), reference.size());
+    std::printf("%-10s %10s %10s %8s\n", "threads", "seconds", "speedup", "check");
+    std::printf("%-10s %10.3f %10.2f %8s\n", "1", serial_s, 1.0, "-");
+    std::printf("%-10s %10.3f %10.2f %8s\n", "2 (index)", first_s, serial_s / first_s, ok ? "ok" : "MISMATCH");
+
+    bool all_ok = ok;
+    for (size_t threads = 2; threads <= max_threads; threads *= 2) {
+        start = std::chrono::steady_clock::now();
+        std::vector<SecondFeatures> features = extract_second_features(db_manager, messages, dir, threads);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ok = same_rows(features, reference);
+        all_ok = all_ok && ok;
+        std::printf("%-10zu %10.3f %10.2f %8s\n", threads, seconds, serial_s / seconds, ok ? "ok" : "MISMATCH");
+    }
+    return all_ok ? 0 : 1;
+}
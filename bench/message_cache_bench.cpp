@@ -0,0 +1,108 @@
+// parses a csv on every core, writes its message cache, then opens the cache cold (its pages
+// dropped from the page cache first, where the os allows it) and warm. checks the mapped
+// messages against the parse.
+// usage: ./message_cache_bench es0604.csv [runs]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "message_cache.h"
+#include "parser.h"
+
+namespace {
+
+bool same(const message &a, const message &b) {
+    return a.id_ == b.id_ && a.time_ == b.time_ && a.size_ == b.size_ && a.price_ == b.price_ &&
+           a.action_ == b.action_ && a.side_ == b.side_ && a.flags_ == b.flags_ && a.sequence_ == b.sequence_;
+}
+
+template<typename F>
+double best_seconds(int runs, F &&f) {
+    double best = 0.0;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = i == 0 || seconds < best ? seconds : best;
+    }
+    return best;
+}
+
+// written pages are synced first, only clean pages can be dropped
+bool drop_page_cache(const std::string &path) {
+#ifdef POSIX_FADV_DONTNEED
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    bool ok = fsync(fd) == 0 && posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return ok;
+#else
+    (void) path;
+    return false;
+#endif
+}
+
+void report(const char *label, size_t count, double seconds) {
+    std::printf("%-12s %10zu msgs %8.3f s %8.1f ns/msg\n", label, count, seconds,
+                count > 0 ? seconds * 1e9 / count : 0.0);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const std::string file_path = argc > 1 ? argv[1] : "es0604.csv";
+    const int runs = argc > 2 ? std::atoi(argv[2]) : 3;
+    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<message> reference;
+    double parse_s = best_seconds(runs, [&]() {
+        Parser parser(file_path);
+        parser.parse(threads);
+        reference = std::move(parser.message_stream_);
+    });
+    if (reference.empty()) {
+        std::fprintf(stderr, "no messages parsed from %s\n", file_path.c_str());
+        return 1;
+    }
+    report("csv parse", reference.size(), parse_s);
+
+    bool written = true;
+    double write_s = best_seconds(runs, [&]() { written = MessageCache::write(file_path, reference) && written; });
+    if (!written) {
+        return 1;
+    }
+    report("cache write", reference.size(), write_s);
+
+    bool ok = true;
+    auto check = [&](const char *label, bool cold) {
+        bool dropped = true;
+        double seconds = 0.0;
+        std::unique_ptr<MessageCache> cache;
+        for (int i = 0; i < runs; ++i) {
+            cache.reset();
+            dropped = (!cold || drop_page_cache(MessageCache::cache_path(file_path))) && dropped;
+            double run_s = best_seconds(1, [&]() { cache = std::make_unique<MessageCache>(file_path, threads); });
+            seconds = i == 0 || run_s < seconds ? run_s : seconds;
+        }
+        MessageSpan messages = cache->messages();
+        size_t mismatches = cache->hit() && messages.size() == reference.size() ? 0 : 1;
+        for (size_t i = 0; i < messages.size() && i < reference.size(); ++i) {
+            mismatches += !same(messages[i], reference[i]);
+        }
+        ok = ok && mismatches == 0;
+        std::printf("%-12s %10zu msgs %8.3f s %8.1f ns/msg %6.2fx %s%s\n", label, messages.size(), seconds,
+                    seconds * 1e9 / std::max<size_t>(messages.size(), 1), parse_s / seconds,
+                    mismatches == 0 ? "ok" : "MISMATCH", dropped ? "" : " (page cache not dropped)");
+    };
+    check("cold open", true);
+    check("warm open", false);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+// 100 point parameter sweep (80 linear model, 20 imbalance) on a thread pool, against the time
+// of a single point run alone. the first point is checked against its standalone result.
+// usage: ./param_sweep_bench es0604.csv es0603.csv [2024-06-04] [2024-06-03] [threads]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "param_sweep.h"
+#include "parser.h"
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const char *file_path = argc > 1 ? argv[1] : "es0604.csv";
+    const char *train_file_path = argc > 2 ? argv[2] : "es0603.csv";
+    const std::string date = argc > 3 ? argv[3] : "2024-06-04";
+    const std::string train_date = argc > 4 ? argv[4] : "2024-06-03";
+    const size_t threads = argc > 5 ? std::strtoul(argv[5], nullptr, 10)
+                                    : std::max(1u, std::thread::hardware_concurrency());
+
+    Parser parser(file_path);
+    Parser train_parser(train_file_path);
+    parser.parse();
+    train_parser.parse();
+    if (parser.message_stream_.empty() || train_parser.message_stream_.empty()) {
+        std::fprintf(stderr, "no messages parsed from %s or %s\n", file_path, train_file_path);
+        return 1;
+    }
+
+    DatabaseManager db_manager("127.0.0.1", 9009);
+    ParameterSweep sweep(db_manager, parser.message_stream_, train_parser.message_stream_);
+    sweep.set_session(date + " 08:30:00.000", date + " 15:00:00.000");
+    sweep.set_train_session(train_date + " 08:30:00.000", train_date + " 15:00:00.000");
+
+    std::vector<SweepPoint> grid = linear_model_grid({3, 5, 8, 12, 16}, {60, 120, 300, 600}, {5, 10, 20, 40});
+    std::vector<SweepPoint> imbalance = imbalance_grid({5, 10, 25, 50, Orderbook::DEPTH_LEVELS}, {0, 0.25, 0.5, 0.75});
+    grid.insert(grid.end(), imbalance.begin(), imbalance.end());
+
+    // the shared preparation (training samples, session checkpoint) is paid once in both runs
+    std::vector<SweepResult> single = sweep.run({grid.front()}, 1);
+    double single_s = single.front().seconds_;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SweepResult> results = sweep.run(grid, threads);
+    double sweep_s = seconds_since(start);
+
+    ParameterSweep::print_table(results);
+    std::printf("\n%zu points on %zu threads in %.3f s, one point alone %.3f s, %zu x %.3f / %zu = %.3f s\n",
+                grid.size(), threads, sweep_s, single_s, grid.size(), single_s, threads,
+                grid.size() * single_s / threads);
+
+    const SweepResult &first = results.front();
+    if (first.pnl_ != single.front().pnl_ || first.trades_ != single.front().trades_ ||
+        first.position_ != single.front().position_) {
+        std::printf("MISMATCH: first point pnl %d trades %d in the sweep, %d trades %d alone\n", first.pnl_,
+                    first.trades_, single.front().pnl_, single.front().trades_);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+// deep-queue trade walks: the compact 24 byte Order (32-bit links, cold fields in a parallel
+// array) against a replica of the previous 64 byte pointer-linked layout.
+// orders are added round-robin across levels, so consecutive orders in one queue are spread
+// through memory the way they are in a real book.
+// usage: ./queue_walk_bench [levels] [orders_per_level] [rounds]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include "orderbook.h"
+
+namespace {
+
+struct LegacyOrder {
+    uint64_t id_;
+    int32_t price_;
+    uint32_t size;
+    bool side_;
+    uint64_t unix_time_;
+    LegacyOrder *next_;
+    LegacyOrder *prev_;
+    Limit *parent_;
+    bool filled_;
+};
+
+static_assert(sizeof(LegacyOrder) == 64, "legacy replica should match the old Order footprint");
+
+// same loop as Orderbook::trade_order, over raw pointers
+uint32_t walk_legacy(LegacyOrder *it, uint32_t size) {
+    while (it != nullptr) {
+        if (size == it->size) {
+            it->filled_ = true;
+            size = 0;
+            break;
+        } else if (size < it->size) {
+            it->size -= size;
+            size = 0;
+            break;
+        } else {
+            size -= it->size;
+            it->filled_ = true;
+            if (size == 0) {
+                break;
+            }
+            it = it->next_;
+        }
+    }
+    return size;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const int levels = argc > 1 ? std::atoi(argv[1]) : 64;
+    const int depth = argc > 2 ? std::atoi(argv[2]) : 4096;
+    const int rounds = argc > 3 ? std::atoi(argv[3]) : 20;
+    const int32_t base_price = 530000;
+    const uint32_t order_size = 2;
+    const uint32_t level_volume = order_size * static_cast<uint32_t>(depth);
+    const double visits = static_cast<double>(levels) * depth * rounds;
+
+    // legacy layout, one contiguous array like a warm slab allocator would give
+    std::vector<LegacyOrder> legacy(static_cast<size_t>(levels) * depth);
+    std::vector<LegacyOrder *> heads(levels, nullptr);
+    std::vector<LegacyOrder *> tails(levels, nullptr);
+    for (int i = 0; i < depth; ++i) {
+        for (int l = 0; l < levels; ++l) {
+            LegacyOrder &order = legacy[static_cast<size_t>(i) * levels + l];
+            order = {static_cast<uint64_t>(i) * levels + l, base_price + l, order_size, false, 0,
+                     nullptr, tails[l], nullptr, false};
+            if (tails[l]) {
+                tails[l]->next_ = &order;
+            } else {
+                heads[l] = &order;
+            }
+            tails[l] = &order;
+        }
+    }
+
+    DatabaseManager db_manager("127.0.0.1", 9009);
+    auto book = std::make_unique<Orderbook>(db_manager);
+    uint64_t id = 1;
+    for (int i = 0; i < depth; ++i) {
+        for (int l = 0; l < levels; ++l) {
+            book->add_limit_order<false>(id++, base_price + l, order_size, 0);
+        }
+    }
+
+    uint32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (int l = 0; l < levels; ++l) {
+            sink += walk_legacy(heads[l], level_volume);
+        }
+    }
+    double legacy_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (int l = 0; l < levels; ++l) {
+            book->trade_order<true>(0, base_price + l, level_volume);
+        }
+    }
+    double compact_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("levels: %d, orders per level: %d, rounds: %d (sink %u)\n", levels, depth, rounds, sink);
+    std::printf("%-26s %6s %12s %10s\n", "layout", "bytes", "ms", "ns/order");
+    std::printf("%-26s %6zu %12.2f %10.2f\n", "legacy pointer links", sizeof(LegacyOrder), legacy_ns / 1e6,
+                legacy_ns / visits);
+    std::printf("%-26s %6zu %12.2f %10.2f\n", "compact hot/cold handles", sizeof(Order), compact_ns / 1e6,
+                compact_ns / visits);
+    return 0;
+}
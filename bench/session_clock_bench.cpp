@@ -0,0 +1,249 @@
+// checks ExchangeZone and SessionClock against the c library (localtime_r/mktime with TZ set)
+// in zones with and without dst, southern and half hour ones: utc offsets, wall time to utc,
+// format, parse and seconds since midnight on random times and minute by minute around every
+// dst change from 1990 to 2040. then the built-in CME rule with no tzdata, and conversion speed.
+// usage: ./session_clock_bench [random times per zone]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <vector>
+#include "session_clock.h"
+
+namespace {
+
+uint64_t mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+struct Rng {
+    uint64_t state_;
+    uint64_t next() { return state_ = mix(state_); }
+    uint64_t below(uint64_t n) { return n == 0 ? 0 : next() % n; }
+};
+
+constexpr int64_t FROM = 631152000;    // 1990-01-01
+constexpr int64_t TO = 2208988800;     // 2040-01-01
+
+void set_tz(const char *tz) {
+    setenv("TZ", tz, 1);
+    tzset();
+}
+
+int64_t libc_offset(int64_t utc) {
+    time_t t = static_cast<time_t>(utc);
+    struct tm tm_buf;
+    localtime_r(&t, &tm_buf);
+    return tm_buf.tm_gmtoff;
+}
+
+class Checker {
+public:
+    Checker(const char *label, const ExchangeZone &zone) : label_(label), zone_(zone) {}
+
+    // everything that can be said about one utc second
+    void check(int64_t utc, uint32_t ms) {
+        ++cases_;
+        time_t t = static_cast<time_t>(utc);
+        struct tm tm_buf;
+        localtime_r(&t, &tm_buf);
+        expect(zone_.utc_offset(utc) == tm_buf.tm_gmtoff, "utc_offset", utc);
+
+        // a wall time that occurs twice maps to its first occurrence, mktime may pick either
+        const int64_t local = utc + tm_buf.tm_gmtoff;
+        int64_t earlier = utc;
+        bool repeated = false;
+        for (int64_t shift: {1800, 3600, 7200}) {
+            if (utc - shift + libc_offset(utc - shift) == local) {
+                earlier = utc - shift;
+            }
+            repeated = repeated || utc + shift + libc_offset(utc + shift) == local;
+        }
+        repeated = repeated || earlier != utc;
+        struct tm back = tm_buf;
+        back.tm_isdst = -1;
+        const int64_t libc_utc = mktime(&back);
+        expect(zone_.to_utc(local) == earlier && (repeated || libc_utc == utc), "to_utc", utc);
+
+        SessionClock clock;
+        clock.set_zone(zone_);
+        const uint64_t ns = static_cast<uint64_t>(utc) * SessionClock::NS_PER_SECOND +
+                            ms * SessionClock::NS_PER_MILLI;
+        clock.advance(ns);
+        char expected[48];
+        std::snprintf(expected, sizeof(expected), "%04d-%02d-%02d %02d:%02d:%02d.%03u", tm_buf.tm_year + 1900,
+                      tm_buf.tm_mon + 1, tm_buf.tm_mday, tm_buf.tm_hour, tm_buf.tm_min, tm_buf.tm_sec, ms);
+        const std::string formatted = clock.format();
+        expect(formatted == expected, "format", utc);
+        expect(SessionClock::parse(formatted, zone_) ==
+               static_cast<uint64_t>(earlier) * SessionClock::NS_PER_SECOND + ms * SessionClock::NS_PER_MILLI,
+               "parse", utc);
+
+        // elapsed time since the local midnight, on days whose midnight exists exactly once
+        struct tm midnight = tm_buf;
+        midnight.tm_hour = 0;
+        midnight.tm_min = 0;
+        midnight.tm_sec = 0;
+        midnight.tm_isdst = -1;
+        const int64_t midnight_utc = mktime(&midnight);
+        if (midnight.tm_hour == 0 && midnight.tm_min == 0 && zone_.to_utc(midnight_utc + midnight.tm_gmtoff) ==
+                                                                 midnight_utc) {
+            expect(clock.seconds_since_midnight() == static_cast<uint32_t>(utc - midnight_utc),
+                   "seconds_since_midnight", utc);
+        }
+    }
+
+    // wall times skipped by a change move an hour (or the size of the jump) on
+    void check_gap(int64_t change) {
+        const int64_t before = libc_offset(change - 1);
+        const int64_t after = libc_offset(change);
+        for (int64_t local = change + before; local < change + after; local += 60) {
+            ++cases_;
+            expect(zone_.to_utc(local) == local - before, "to_utc in a gap", local);
+        }
+    }
+
+    // every change in [from, to): found hour by hour, pinned to the second, checked by the minute
+    void check_changes(int64_t from, int64_t to) {
+        for (int64_t hour = from; hour < to; hour += 3600) {
+            if (libc_offset(hour) == libc_offset(hour + 3600)) {
+                continue;
+            }
+            int64_t lo = hour;
+            int64_t hi = hour + 3600;
+            while (hi - lo > 1) {
+                int64_t mid = lo + (hi - lo) / 2;
+                (libc_offset(mid) == libc_offset(lo) ? lo : hi) = mid;
+            }
+            ++changes_;
+            for (int64_t utc = hi - 3 * 3600; utc <= hi + 3 * 3600; utc += 60) {
+                check(utc, 0);
+            }
+            check(hi - 1, 999);
+            check(hi, 0);
+            if (libc_offset(hi) > libc_offset(hi - 1)) {
+                check_gap(hi);
+            }
+        }
+    }
+
+    bool report() const {
+        std::printf("%-32s %9zu cases %4zu dst changes: %s\n", label_, cases_, changes_,
+                    failures_ == 0 ? "ok" : "FAILED");
+        return failures_ == 0;
+    }
+
+private:
+    const char *label_;
+    const ExchangeZone &zone_;
+    size_t cases_ = 0;
+    size_t changes_ = 0;
+    size_t failures_ = 0;
+
+    void expect(bool ok, const char *what, int64_t seconds) {
+        if (!ok && failures_++ < 5) {
+            std::printf("%s: %s differs at %lld\n", label_, what, static_cast<long long>(seconds));
+        }
+    }
+};
+
+bool check_zone(const char *name, const char *tz, size_t random_times, bool rule_only = false) {
+    set_tz(tz);
+    ExchangeZone zone(name);
+    if (!zone.valid()) {
+        std::printf("%-32s not in this tzdata, skipped\n", name);
+        return true;
+    }
+    Checker checker(name, zone);
+    Rng rng{std::hash<std::string>{}(name)};
+    // zone files from the first full day after the epoch (an earlier midnight would be before
+    // it), a bare rule over the years the changes are checked in
+    const int64_t from = rule_only ? FROM : 2 * 86400;
+    for (size_t i = 0; i < random_times; ++i) {
+        checker.check(from + static_cast<int64_t>(rng.below(TO - from)), static_cast<uint32_t>(rng.below(1000)));
+    }
+    checker.check_changes(FROM, TO);
+    return checker.report();
+}
+
+// the zone cme() falls back to when there is no tzdata, against the real chicago since 2007
+bool check_cme_fallback(size_t random_times) {
+    set_tz(ExchangeZone::CME);
+    const char *dir = std::getenv("TZDIR");
+    const std::string saved = dir ? dir : "";
+    setenv("TZDIR", "/nonexistent", 1);
+    ExchangeZone fallback(ExchangeZone::CME, ExchangeZone::CME_RULE);
+    dir ? setenv("TZDIR", saved.c_str(), 1) : unsetenv("TZDIR");
+
+    Checker checker("America/Chicago without tzdata", fallback);
+    Rng rng{7};
+    constexpr int64_t FROM_2007 = 1167609600;
+    for (size_t i = 0; i < random_times; ++i) {
+        checker.check(FROM_2007 + static_cast<int64_t>(rng.below(TO - FROM_2007)), 0);
+    }
+    checker.check_changes(FROM_2007, TO);
+    return fallback.valid() && checker.report();
+}
+
+void time_conversions() {
+    const ExchangeZone &zone = ExchangeZone::cme();
+    constexpr size_t COUNT = 1000000;
+    Rng rng{42};
+    std::vector<uint64_t> times(COUNT);
+    for (auto &t: times) {
+        t = static_cast<uint64_t>(FROM + static_cast<int64_t>(rng.below(TO - FROM))) * SessionClock::NS_PER_SECOND;
+    }
+
+    SessionClock clock;
+    uint64_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t t: times) {
+        clock.advance(t);
+        sink += clock.seconds_since_midnight();
+    }
+    double roll_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<std::string> strings;
+    strings.reserve(COUNT);
+    start = std::chrono::steady_clock::now();
+    for (uint64_t t: times) {
+        clock.advance(t);
+        strings.push_back(clock.format());
+    }
+    double format_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (const auto &s: strings) {
+        sink += SessionClock::parse(s, zone);
+    }
+    double parse_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("new day every advance: %.1f ns, format: %.1f ns, parse: %.1f ns (%llu)\n", roll_s * 1e9 / COUNT,
+                format_s * 1e9 / COUNT, parse_s * 1e9 / COUNT, static_cast<unsigned long long>(sink % 10));
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const size_t random_times = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+
+    const char *zones[] = {"America/Chicago", "America/New_York", "Europe/London", "Europe/Berlin",
+                           "Australia/Sydney", "Australia/Lord_Howe", "Pacific/Chatham", "America/Sao_Paulo",
+                           "Asia/Kolkata", "Asia/Tokyo", "UTC"};
+    bool ok = true;
+    for (const char *zone: zones) {
+        ok = check_zone(zone, zone, random_times) && ok;
+    }
+    // posix rules given directly, the c library reads the same strings
+    ok = check_zone(ExchangeZone::CME_RULE, ExchangeZone::CME_RULE, random_times, true) && ok;
+    ok = check_zone("AEST-10AEDT,M10.1.0,M4.1.0/3", "AEST-10AEDT,M10.1.0,M4.1.0/3", random_times, true) && ok;
+    ok = check_cme_fallback(random_times) && ok;
+
+    time_conversions();
+    return ok ? 0 : 1;
+}
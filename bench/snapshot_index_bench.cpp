@@ -0,0 +1,86 @@
+// builds a SnapshotIndex for an MBO csv, then answers random "book at time T" queries through
+// it and through a full replay from the start of the file, checking both give the same book.
+// usage: ./snapshot_index_bench es0604.csv [interval_seconds] [queries] [index_dir]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "snapshot_index.h"
+#include "parser.h"
+
+namespace {
+
+bool same_book(const Orderbook &a, const Orderbook &b) {
+    return a.get_bbo() == b.get_bbo() && a.get_count() == b.get_count() && a.bid_vol_ == b.bid_vol_ &&
+           a.ask_vol_ == b.ask_vol_ && a.ct_ == b.ct_ && a.bids_.size() == b.bids_.size() &&
+           a.offers_.size() == b.offers_.size();
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const char *file_path = argc > 1 ? argv[1] : "es0604.csv";
+    const uint32_t interval = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 60;
+    const int queries = argc > 3 ? std::atoi(argv[3]) : 20;
+    const std::string dir = argc > 4 ? argv[4] : "snapshots";
+
+    Parser parser(file_path);
+    parser.parse();
+    const auto &messages = parser.message_stream_;
+    if (messages.empty()) {
+        std::fprintf(stderr, "no messages parsed from %s\n", file_path);
+        return 1;
+    }
+
+    DatabaseManager db_manager("127.0.0.1", 9009);
+    Orderbook indexed(db_manager);
+    Orderbook replayed(db_manager);
+
+    auto start = std::chrono::steady_clock::now();
+    if (!SnapshotIndex::build(indexed, messages, dir, interval)) {
+        return 1;
+    }
+    SnapshotIndex index(dir);
+    if (!index.valid()) {
+        return 1;
+    }
+    std::printf("indexed %zu messages into %zu snapshots (every %us) in %.3f s\n", messages.size(),
+                index.snapshots().size(), interval, seconds_since(start));
+
+    std::mt19937_64 rng(42);
+    uint64_t first = messages.front().time_;
+    uint64_t span = messages.back().time_ - first + 1;
+    double indexed_s = 0.0;
+    double replayed_s = 0.0;
+    int mismatches = 0;
+    for (int q = 0; q < queries; ++q) {
+        uint64_t ts = first + rng() % span;
+
+        start = std::chrono::steady_clock::now();
+        size_t applied = index.book_at(indexed, messages, ts);
+        indexed_s += seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        replayed.reset();
+        size_t replayed_count = 0;
+        while (replayed_count < messages.size() && messages[replayed_count].time_ <= ts) {
+            replayed.process_msg(messages[replayed_count++]);
+        }
+        replayed_s += seconds_since(start);
+
+        if (applied != replayed_count || !same_book(indexed, replayed)) {
+            std::fprintf(stderr, "mismatch at ts %llu: %zu vs %zu messages\n", static_cast<unsigned long long>(ts),
+                         applied, replayed_count);
+            ++mismatches;
+        }
+    }
+
+    std::printf("%d queries: book_at %.2f ms/query, full replay %.2f ms/query, %s\n", queries,
+                indexed_s * 1e3 / queries, replayed_s * 1e3 / queries, mismatches ? "MISMATCH" : "ok");
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,329 @@
+// checks TimerWheel against a brute force reference on random schedule/cancel/advance scripts,
+// with callbacks that schedule and cancel in turn, deadlines from one tick to years out, periods
+// that fall behind and many timers on the same tick. then times schedule + fire throughput.
+// usage: ./timer_wheel_bench [scripts] [ops per script]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <vector>
+#include "timer_wheel.h"
+
+namespace {
+
+uint64_t mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+struct Rng {
+    uint64_t state_;
+    uint64_t next() { return state_ = mix(state_); }
+    uint64_t below(uint64_t n) { return n == 0 ? 0 : next() % n; }
+};
+
+// every timer fired (with the advance() time it saw) and every cancel result, in order
+using Log = std::vector<uint64_t>;
+
+// the wheel's contract spelled out on a flat list: a timer is due on tick max(deadline rounded
+// up, position when it was scheduled). each round takes the earliest due tick, fires what is
+// due on it then in (deadline, schedule order) order, timers scheduled by those callbacks wait
+// for the next round
+class ReferenceWheel {
+public:
+    ReferenceWheel(uint64_t tick_ns, uint64_t start_ns) : tick_ns_(tick_ns), elapsed_(start_ns / tick_ns) {}
+
+    size_t schedule(uint64_t period_ns, uint64_t first_ns) {
+        timers_.push_back({first_ns, period_ns, due(first_ns), true});
+        return timers_.size() - 1;
+    }
+
+    bool cancel(size_t id) {
+        if (id >= timers_.size() || !timers_[id].active_) {
+            return false;
+        }
+        timers_[id].active_ = false;
+        return true;
+    }
+
+    template<typename F>
+    void advance(uint64_t now_ns, F &&fire) {
+        const uint64_t now = now_ns / tick_ns_;
+        while (true) {
+            uint64_t tick = UINT64_MAX;
+            bool any = false;
+            for (const Timer &timer: timers_) {
+                if (timer.active_ && timer.due_ <= now) {
+                    tick = any ? std::min(tick, timer.due_) : timer.due_;
+                    any = true;
+                }
+            }
+            if (!any) {
+                break;
+            }
+            elapsed_ = tick;
+            std::vector<size_t> round;
+            for (size_t i = 0; i < timers_.size(); ++i) {
+                if (timers_[i].active_ && timers_[i].due_ == tick) {
+                    round.push_back(i);
+                }
+            }
+            std::sort(round.begin(), round.end(), [this](size_t a, size_t b) {
+                return timers_[a].deadline_ != timers_[b].deadline_ ? timers_[a].deadline_ < timers_[b].deadline_
+                                                                    : a < b;
+            });
+            for (size_t id: round) {
+                if (!timers_[id].active_) {
+                    continue;
+                }
+                fire(id, now_ns);
+                Timer &timer = timers_[id];
+                if (!timer.active_) {
+                    continue;
+                }
+                if (timer.period_ == 0) {
+                    timer.active_ = false;
+                    continue;
+                }
+                uint64_t missed = now_ns >= timer.deadline_ ? (now_ns - timer.deadline_) / timer.period_ : 0;
+                unsigned __int128 next = timer.deadline_ + static_cast<unsigned __int128>(missed + 1) * timer.period_;
+                if (next > UINT64_MAX) {
+                    timer.active_ = false;
+                    continue;
+                }
+                timer.deadline_ = static_cast<uint64_t>(next);
+                timer.due_ = due(timer.deadline_);
+            }
+        }
+        elapsed_ = std::max(elapsed_, now);
+    }
+
+    size_t size() const {
+        return std::count_if(timers_.begin(), timers_.end(), [](const Timer &timer) { return timer.active_; });
+    }
+
+private:
+    struct Timer {
+        uint64_t deadline_;
+        uint64_t period_;
+        uint64_t due_;
+        bool active_;
+    };
+
+    uint64_t tick_ns_;
+    uint64_t elapsed_;
+    std::vector<Timer> timers_;
+
+    uint64_t due(uint64_t ns) const { return std::max(ns / tick_ns_ + (ns % tick_ns_ != 0), elapsed_); }
+};
+
+// the same script on both: ids are schedule order, callbacks decide what to do from the id
+// and how often it fired, so both sides take the same actions
+template<typename Backend>
+class Driver {
+public:
+    Driver(uint64_t tick_ns, uint64_t start_ns) : backend_(*this, tick_ns, start_ns) {}
+
+    void schedule(uint64_t period_ns, uint64_t first_ns) {
+        backend_.schedule(period_ns, first_ns);
+        fired_.push_back(0);
+    }
+
+    void cancel(size_t id) { log_.push_back(backend_.cancel(id) ? 2 : 3); }
+
+    void advance(uint64_t now_ns) {
+        backend_.advance(now_ns);
+        log_.push_back(4);
+        log_.push_back(backend_.size());
+    }
+
+    void on_fire(size_t id, uint64_t now_ns) {
+        log_.push_back(1);
+        log_.push_back(id);
+        log_.push_back(now_ns);
+        uint64_t r = mix(id * 1000003 + ++fired_[id]);
+        switch (r % 8) {
+            case 0:
+                // possibly in the past, fires within the same advance()
+                schedule(0, now_ns - std::min<uint64_t>(now_ns, (r >> 8) % 3000) + (r >> 20) % 2000);
+                break;
+            case 1:
+                cancel((r >> 8) % fired_.size());
+                break;
+            case 2:
+                cancel(id);
+                break;
+            default:
+                break;
+        }
+    }
+
+    size_t count() const { return fired_.size(); }
+
+    const Log &log() const { return log_; }
+
+private:
+    Backend backend_;
+    std::vector<uint64_t> fired_;
+    Log log_;
+};
+
+class WheelBackend {
+public:
+    WheelBackend(Driver<WheelBackend> &driver, uint64_t tick_ns, uint64_t start_ns)
+            : driver_(driver), wheel_(tick_ns, start_ns) {}
+
+    void schedule(uint64_t period_ns, uint64_t first_ns) {
+        contexts_.push_back({this, ids_.size()});
+        ids_.push_back(wheel_.schedule_every(period_ns, first_ns, &WheelBackend::on_timer, &contexts_.back()));
+    }
+
+    bool cancel(size_t id) { return wheel_.cancel(ids_[id]); }
+
+    void advance(uint64_t now_ns) { wheel_.advance(now_ns); }
+
+    size_t size() const { return wheel_.size(); }
+
+private:
+    struct Context {
+        WheelBackend *self_;
+        size_t id_;
+    };
+
+    Driver<WheelBackend> &driver_;
+    TimerWheel wheel_;
+    std::vector<TimerWheel::TimerId> ids_;
+    std::deque<Context> contexts_;
+
+    static void on_timer(uint64_t now_ns, void *context) {
+        auto *timer = static_cast<Context *>(context);
+        timer->self_->driver_.on_fire(timer->id_, now_ns);
+    }
+};
+
+class ReferenceBackend {
+public:
+    ReferenceBackend(Driver<ReferenceBackend> &driver, uint64_t tick_ns, uint64_t start_ns)
+            : driver_(driver), wheel_(tick_ns, start_ns) {}
+
+    void schedule(uint64_t period_ns, uint64_t first_ns) { wheel_.schedule(period_ns, first_ns); }
+
+    bool cancel(size_t id) { return wheel_.cancel(id); }
+
+    void advance(uint64_t now_ns) {
+        wheel_.advance(now_ns, [this](size_t id, uint64_t now) { driver_.on_fire(id, now); });
+    }
+
+    size_t size() const { return wheel_.size(); }
+
+private:
+    Driver<ReferenceBackend> &driver_;
+    ReferenceWheel wheel_;
+};
+
+// deadlines spread over every level: a span of up to 2^k ns for a random k below 48
+uint64_t random_span(Rng &rng) {
+    return rng.below(1ULL << rng.below(48));
+}
+
+template<typename Backend>
+Log run_script(uint64_t seed, size_t ops, uint64_t tick_ns, uint64_t start_ns) {
+    Driver<Backend> driver(tick_ns, start_ns);
+    Rng rng{seed};
+    uint64_t now = start_ns;
+    for (size_t i = 0; i < ops; ++i) {
+        uint64_t op = rng.below(16);
+        if (op < 5) {
+            // one-shot, sometimes already due
+            uint64_t first = rng.below(4) == 0 ? now - std::min(now, rng.below(5000)) : now + random_span(rng);
+            driver.schedule(0, first);
+        } else if (op < 7) {
+            // a burst on one deadline and its neighbours, to order ties within a tick
+            uint64_t first = now + rng.below(64) * tick_ns + rng.below(3);
+            for (uint64_t k = rng.below(6) + 2; k > 0; --k) {
+                driver.schedule(0, first + rng.below(2));
+            }
+        } else if (op < 9) {
+            driver.schedule(rng.below(1ULL << rng.below(32)) + 1, now + random_span(rng));
+        } else if (op < 11) {
+            if (driver.count() > 0) {
+                driver.cancel(rng.below(driver.count()));
+            }
+        } else {
+            // mostly small steps, sometimes far enough to skip many periods and levels
+            now += rng.below(8) == 0 ? random_span(rng) : rng.below(3000);
+            driver.advance(now);
+        }
+    }
+    return driver.log();
+}
+
+bool check_empty_advance() {
+    // nothing scheduled and the whole 64 bit range at once
+    TimerWheel wheel(1, 0);
+    wheel.advance(UINT64_MAX);
+    int fired = 0;
+    wheel.schedule_at(100, [](uint64_t, void *context) { ++*static_cast<int *>(context); }, &fired);
+    wheel.schedule_every(1ULL << 62, 1ULL << 62, [](uint64_t, void *context) { ++*static_cast<int *>(context); },
+                         &fired);
+    wheel.advance(UINT64_MAX);
+    wheel.advance(UINT64_MAX);
+    return fired == 2 && wheel.empty();
+}
+
+double throughput_ns(size_t timers) {
+    TimerWheel wheel(1000, 0);
+    uint64_t fired = 0;
+    auto start = std::chrono::steady_clock::now();
+    Rng rng{42};
+    uint64_t now = 0;
+    for (size_t i = 0; i < timers; ++i) {
+        wheel.schedule_at(now + rng.below(10'000'000'000ULL), [](uint64_t, void *context) {
+            ++*static_cast<uint64_t *>(context);
+        }, &fired);
+        now += 1000;
+        wheel.advance(now);
+    }
+    wheel.advance(UINT64_MAX);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return fired == timers ? seconds * 1e9 / timers : -1.0;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const size_t scripts = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 300;
+    const size_t ops = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+
+    bool ok = check_empty_advance();
+    std::printf("empty and end of time advance: %s\n", ok ? "ok" : "FAILED");
+
+    size_t failed = 0;
+    size_t events = 0;
+    for (size_t i = 0; i < scripts; ++i) {
+        const uint64_t tick_ns = i % 3 == 0 ? 1 : i % 3 == 1 ? 7 : 1000;
+        const uint64_t start_ns = mix(i) % (1ULL << 50);
+        Log wheel = run_script<WheelBackend>(i, ops, tick_ns, start_ns);
+        Log reference = run_script<ReferenceBackend>(i, ops, tick_ns, start_ns);
+        events += wheel.size();
+        if (wheel != reference) {
+            size_t at = std::mismatch(wheel.begin(), wheel.end(), reference.begin(), reference.end()).first -
+                        wheel.begin();
+            std::printf("script %zu (tick %llu): logs differ at entry %zu\n", i,
+                        static_cast<unsigned long long>(tick_ns), at);
+            ++failed;
+        }
+    }
+    std::printf("%zu scripts x %zu ops against the reference: %s (%zu log entries)\n", scripts, ops,
+                failed == 0 ? "ok" : "MISMATCH", events);
+    ok = ok && failed == 0;
+
+    for (size_t timers: {100000, 1000000}) {
+        std::printf("%8zu timers: %.1f ns per schedule + fire\n", timers, throughput_ns(timers));
+    }
+    return ok ? 0 : 1;
+}
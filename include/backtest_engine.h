@@ -0,0 +1,155 @@
+#ifndef DATABENTO_ORDERBOOK_BACKTEST_ENGINE_H
+#define DATABENTO_ORDERBOOK_BACKTEST_ENGINE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "orderbook.h"
+#include "database.h"
+#include "message.h"
+#include "message_source.h"
+#include "strategy.h"
+#include "timer_wheel.h"
+
+struct BacktestStats {
+    size_t warm_start_messages_;   // pre-session messages restored from a checkpoint or replayed
+    double warm_start_seconds_;
+    size_t messages_;              // applied by the replay loop
+    uint64_t events_;              // exchange events those messages completed
+    double seconds_;               // wall time of the replay loop
+};
+
+// the replay loop shared by the gui Backtester and backtest_cli, with no Qt in it. fits the
+// model on the training day, warm starts the book at the session open and replays the rest of
+// the day at full speed. strategies, db snapshots and progress run on exchange time timers,
+// the front end hooks in through plain callbacks that are all optional.
+class BacktestEngine {
+public:
+    using TradeCallback = void (*)(const std::string& timestamp, bool is_buy, int32_t price, void* context);
+    using ProgressCallback = void (*)(int progress, void* context);
+    // called between exchange events once the session is open, the gui refreshes from it
+    using PollCallback = void (*)(void* context);
+
+    // exchange time periods of the timers driven by the replay
+    static constexpr uint64_t STRATEGY_PERIOD_NS = SessionClock::NS_PER_SECOND;
+    static constexpr uint64_t DB_SNAPSHOT_PERIOD_NS = 100 * SessionClock::NS_PER_MILLI;
+    static constexpr uint64_t PROGRESS_PERIOD_NS = 10 * SessionClock::NS_PER_SECOND;
+
+    // both streams are read in place and must outlive the engine. it starts without strategies,
+    // the first one added is the one train_model() fits
+    BacktestEngine(DatabaseManager& db_manager, MessageSpan messages, MessageSpan train_messages);
+
+    // same over any source, e.g. a CsvStreamSource that parses while the replay runs. both must
+    // outlive the engine
+    BacktestEngine(DatabaseManager& db_manager, MessageSource& messages, MessageSource& train_messages);
+
+    // exchange time "yyyy-mm-dd hh:mm:ss.zzz", see SessionClock::parse
+    void set_session(const std::string& start_time, const std::string& end_time);
+
+    void set_train_session(const std::string& start_time, const std::string& end_time);
+
+    void set_trade_callback(TradeCallback callback, void* context) {
+        trade_callback_ = callback;
+        trade_context_ = context;
+    }
+
+    void set_progress_callback(ProgressCallback callback, void* context) {
+        progress_callback_ = callback;
+        progress_context_ = context;
+    }
+
+    void set_poll_callback(PollCallback callback, void* context) {
+        poll_callback_ = callback;
+        poll_context_ = context;
+    }
+
+    // book snapshots to the database every DB_SNAPSHOT_PERIOD_NS, on by default
+    void set_db_snapshots(bool enabled) { db_snapshots_ = enabled; }
+
+    void add_strategy(std::unique_ptr<Strategy> strategy);
+
+    // brings `book` to the state just before the first message at or after `start_time`,
+    // restoring a checkpoint from an earlier run when there is one and writing it otherwise.
+    // returns the index of that first session message
+    static size_t warm_start(Orderbook& book, MessageSpan messages, const std::string& start_time,
+                             const std::string& tag, const std::string& checkpoint_dir = "checkpoints");
+
+    // same for a source read from its first message, which is left at the first session
+    // message. a stream has no index to key a checkpoint on, its pre-session messages are
+    // replayed as they arrive
+    static size_t warm_start(Orderbook& book, MessageSource& messages, const std::string& start_time,
+                             const std::string& tag, const std::string& checkpoint_dir = "checkpoints");
+
+    // replays a whole training session into `book`, leaving one voi_history_/mid_prices_ sample
+    // per second of exchange time after the open. returns the number of messages applied
+    static size_t sample_session(Orderbook& book, MessageSpan messages,
+                                 const std::string& start_time, const std::string& end_time);
+
+    static size_t sample_session(Orderbook& book, MessageSource& messages,
+                                 const std::string& start_time, const std::string& end_time);
+
+    // replays the training session and fits the linear model on its per-second voi
+    void train_model();
+
+    // replays from the current position until the end of the stream or stop(). a run from
+    // the first message warm starts the book at the session open
+    BacktestStats run();
+
+    // makes run() return after the event it is in, safe from any thread
+    void stop() { running_ = false; }
+
+    // back to the start of the stream with a fresh book, the strategies are kept and reset
+    void reset();
+
+    bool running() const { return running_; }
+
+    size_t message_index() const { return messages_->position(); }
+
+    // 0 while streaming, the length is only known at the end
+    size_t message_count() const { return messages_->size(); }
+
+    // the whole stream has been replayed
+    bool finished() const { return messages_->exhausted(); }
+
+    Orderbook& book() { return *book_; }
+
+    const std::vector<std::unique_ptr<Strategy>>& strategies() const { return strategies_; }
+
+private:
+    DatabaseManager& db_manager_;
+    // vector sources made by the vector constructor
+    std::unique_ptr<VectorSource> owned_messages_;
+    std::unique_ptr<VectorSource> owned_train_messages_;
+    MessageSource* messages_;
+    MessageSource* train_messages_;
+    std::unique_ptr<Orderbook> book_;
+    std::unique_ptr<Orderbook> train_book_;
+    std::vector<std::unique_ptr<Strategy>> strategies_;
+    TimerWheel timers_;
+    std::atomic<bool> running_{false};
+    bool db_snapshots_ = true;
+
+    std::string start_time_ = "2024-06-04 08:30:00.000";
+    std::string end_time_ = "2024-06-04 15:00:00.000";
+    std::string train_start_time_ = "2024-06-03 08:30:00.000";
+    std::string train_end_time_ = "2024-06-03 15:00:00.000";
+
+    TradeCallback trade_callback_ = nullptr;
+    void* trade_context_ = nullptr;
+    ProgressCallback progress_callback_ = nullptr;
+    void* progress_context_ = nullptr;
+    PollCallback poll_callback_ = nullptr;
+    void* poll_context_ = nullptr;
+
+    // (re)arms the strategy, db snapshot and progress timers from the book's current time
+    void schedule_timers();
+
+    static void on_strategy_timer(uint64_t now_ns, void* context);
+    static void on_db_snapshot_timer(uint64_t now_ns, void* context);
+    static void on_progress_timer(uint64_t now_ns, void* context);
+};
+
+#endif //DATABENTO_ORDERBOOK_BACKTEST_ENGINE_H
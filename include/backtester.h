@@ -9,18 +9,23 @@
 #include "orderbook.h"
 #include "database.h"
 #include "message.h"
-#include "../src/strategies/linear_model_strat.cpp"
-#include "../src/strategies/imbalance_strat.cpp"
+#include "backtest_engine.h"
+#include "message_source.h"
 #include <vector>
 #include <memory>
 #include <atomic>
 
+// Qt front end of BacktestEngine: runs it from a QTimer, turns its callbacks into signals and
+// keeps the gui responsive while it replays
 class Backtester : public QObject {
 Q_OBJECT
 
 public:
     explicit Backtester(DatabaseManager& db_manager,
                         const std::vector<message>& messages, const std::vector<message>& train_messages, QObject* parent = nullptr);
+    // replays straight from sources, e.g. CsvStreamSource, which must outlive the backtester
+    Backtester(DatabaseManager& db_manager, MessageSource& messages, MessageSource& train_messages,
+               QObject* parent = nullptr);
     ~Backtester() override;
 
     void add_strategy(std::unique_ptr<Strategy> strategy);
@@ -47,30 +52,24 @@ signals:
 
 private:
     QTimer *backtest_timer_;
-    std::shared_ptr<Orderbook> book_;
-    std::unique_ptr<Orderbook> train_book_;
-    size_t train_message_index_;
-
-    std::vector<std::unique_ptr<Strategy>> strategies_;
-    DatabaseManager& db_manager_;
-    bool first_update_;
-    size_t current_message_index_;
+    QElapsedTimer update_timer_;
+    BacktestEngine engine_;
+    uint64_t gui_bbo_version_ = 0;
     const int UPDATE_INTERVAL = 1000;
     std::atomic<bool> running_;
-    std::vector<message> messages_;
-    std::vector<message> train_messages_;
-    const std::string start_time_ = "2024-06-04 09:30:00.000";
-    const std::string end_time_ = "2024-06-04 16:00:00.000";
-    const std::string train_start_time_ = "2024-06-03 09:30:00.000";
-    const std::string train_end_time_ = "2024-06-03 16:00:00.000";
+    bool restart_pending_ = false;   // restart_backtest() stopped a run, run_backtest() starts over
     QThread worker_thread_;
 
+    void setup(DatabaseManager& db_manager);
     void update_gui();
-    void process_message(const message& msg);
     void reset_state();
 
+    static void on_trade(const std::string& timestamp, bool is_buy, int32_t price, void* context);
+    static void on_progress(int progress, void* context);
+    static void on_poll(void* context);
+
     void log(const QString& message) {
         qDebug() << QTime::currentTime().toString("hh:mm:ss.zzz")
                  << "[Backtester]" << message;
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,55 @@
+#ifndef DATABENTO_ORDERBOOK_BBO_H
+#define DATABENTO_ORDERBOOK_BBO_H
+
+#include <cstdint>
+
+// top of book as cached by Orderbook. a side with no levels has price, volume and order count 0.
+struct Bbo {
+    int32_t bid_price_ = 0;
+    int32_t ask_price_ = 0;
+    uint64_t bid_volume_ = 0;
+    uint64_t ask_volume_ = 0;
+    uint32_t bid_orders_ = 0;
+    uint32_t ask_orders_ = 0;
+
+    bool operator==(const Bbo &other) const {
+        return bid_price_ == other.bid_price_ && ask_price_ == other.ask_price_ &&
+               bid_volume_ == other.bid_volume_ && ask_volume_ == other.ask_volume_ &&
+               bid_orders_ == other.bid_orders_ && ask_orders_ == other.ask_orders_;
+    }
+
+    bool operator!=(const Bbo &other) const { return !(*this == other); }
+};
+
+// volume order imbalance between two consecutive top of book samples: the volume added at a
+// bid that held or improved minus the volume added at an ask that held or improved
+inline int32_t order_imbalance(const Bbo &prev, const Bbo &curr) {
+    int32_t bid_delta = curr.bid_price_ - prev.bid_price_;
+    int32_t ask_delta = curr.ask_price_ - prev.ask_price_;
+
+    int32_t bid_cv = 0;
+    int32_t ask_cv = 0;
+
+    if (bid_delta >= 0) {
+        if (bid_delta == 0) {
+            bid_cv = static_cast<int32_t>(curr.bid_volume_) - static_cast<int32_t>(prev.bid_volume_);
+        } else {
+            bid_cv = static_cast<int32_t>(curr.bid_volume_);
+        }
+    }
+
+    if (ask_delta <= 0) {
+        if (ask_delta == 0) {
+            ask_cv = static_cast<int32_t>(curr.ask_volume_) - static_cast<int32_t>(prev.ask_volume_);
+        } else {
+            ask_cv = static_cast<int32_t>(curr.ask_volume_);
+        }
+    }
+
+    return bid_cv - ask_cv;
+}
+
+// invoked synchronously from the book thread whenever the cached Bbo changes
+using BboCallback = void (*)(const Bbo &bbo, void *context);
+
+#endif //DATABENTO_ORDERBOOK_BBO_H
@@ -0,0 +1,134 @@
+#ifndef DATABENTO_ORDERBOOK_BOOK_MANAGER_H
+#define DATABENTO_ORDERBOOK_BOOK_MANAGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "orderbook.h"
+#include "order_map.h"
+#include "lock_free_queue.h"
+#include "message.h"
+#include "database.h"
+
+struct InstrumentSnapshot {
+    uint32_t instrument_id_;
+    Bbo bbo_;
+    int32_t bid_vol_;
+    int32_t ask_vol_;
+    double imbalance_;
+    double vwap_;
+    uint64_t last_time_;     // time_ of the last message applied to the book
+    uint64_t message_count_;
+};
+
+struct BookSnapshot {
+    uint64_t sequence_;                           // messages submitted before the snapshot point, a book
+                                                  // inside an event there is captured at the event's end
+    std::vector<InstrumentSnapshot> instruments_; // sorted by instrument id
+};
+
+// routes a multi-instrument MBO stream to one Orderbook per instrument_id_. instruments are
+// spread round-robin over worker shards; a shard owns its books, runs on its own (pinned)
+// thread and is fed by the submitting thread through its own SPSC ring, so books are never
+// shared between threads.
+// snapshots use marker items: request_snapshot() pushes a marker into every ring at the same
+// stream position and each worker copies the state of its books when it dequeues it. the
+// merged result is consistent across instruments without pausing or synchronising workers.
+// a marker that lands inside an exchange event is held until no book of the shard is in one,
+// so a snapshot never pairs a half-applied book with the previous event's imbalance.
+class BookManager {
+public:
+    // cores[i % cores.size()] is the core for shard i, an empty list pins shard i to core i + 1
+    // (core 0 is left to the submitting thread). orders_per_book sizes each book's OrderPool.
+    BookManager(DatabaseManager &db_manager, size_t num_shards, std::vector<int> cores = {},
+                size_t orders_per_book = 1 << 16);
+
+    ~BookManager();
+
+    BookManager(const BookManager &) = delete;
+    BookManager &operator=(const BookManager &) = delete;
+
+    void start();
+
+    // drains every ring, then joins the workers
+    void stop();
+
+    // submit / request_snapshot must all be called from one thread
+    void submit(const message &msg);
+
+    void submit(const message *msgs, size_t count);
+
+    // ticket for a snapshot of every book as of the messages submitted so far
+    uint64_t request_snapshot();
+
+    // any thread. true (and `out` filled) once every shard has reached the marker
+    bool poll_snapshot(uint64_t ticket, BookSnapshot &out);
+
+    BookSnapshot wait_snapshot(uint64_t ticket);
+
+    size_t num_shards() const { return shards_.size(); }
+
+    uint64_t submitted() const { return sequence_; }
+
+    // direct access to a book, only while the workers are stopped. nullptr if never seen
+    Orderbook *book(uint32_t instrument_id);
+
+private:
+    static constexpr size_t RING_SIZE = 1 << 16;
+
+    struct SnapshotRequest {
+        uint64_t sequence_;
+        std::vector<std::vector<InstrumentSnapshot>> shard_parts_;
+        std::atomic<size_t> remaining_;
+    };
+
+    // a message, or a snapshot marker when snapshot_ is set
+    struct ShardItem {
+        message msg_;
+        SnapshotRequest *snapshot_;
+    };
+
+    struct Shard {
+        size_t index_;
+        int core_;
+        LockFreeQueue<ShardItem, RING_SIZE> ring_;
+        std::vector<std::unique_ptr<Orderbook>> books_;
+        std::vector<uint32_t> instrument_ids_;
+        std::vector<uint64_t> last_times_;
+        OrderMap<uint32_t> book_index_; // instrument id -> slot in books_, worker thread only
+        std::vector<SnapshotRequest *> pending_; // markers waiting for the open events to close
+        size_t open_events_ = 0;                // books with in_event() set
+        std::thread thread_;
+    };
+
+    DatabaseManager &db_manager_;
+    size_t orders_per_book_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    OrderMap<uint32_t> shard_of_; // instrument id -> shard, submitting thread only
+    size_t next_shard_ = 0;
+    uint64_t sequence_ = 0;
+    uint64_t next_ticket_ = 0;
+    std::atomic<bool> running_{false};
+
+    std::mutex snapshot_mutex_;
+    std::map<uint64_t, std::unique_ptr<SnapshotRequest>> snapshots_;
+
+    void enqueue(Shard &shard, const ShardItem &item);
+
+    void run_shard(Shard &shard);
+
+    // slot of the instrument's book in shard.books_, created on first use
+    uint32_t book_slot(Shard &shard, uint32_t instrument_id);
+
+    void capture(Shard &shard, SnapshotRequest &request);
+
+    // captures every pending marker, in ring order
+    void capture_pending(Shard &shard);
+};
+
+#endif //DATABENTO_ORDERBOOK_BOOK_MANAGER_H
@@ -0,0 +1,74 @@
+#ifndef DATABENTO_ORDERBOOK_BOOK_SIDE_H
+#define DATABENTO_ORDERBOOK_BOOK_SIDE_H
+
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <type_traits>
+#include "limit.h"
+#include "price_ladder.h"
+#include "level_vector.h"
+
+enum class BookBackend {
+    Map,
+    Ladder,
+    Vector
+};
+
+// selected at compile time, e.g. -DORDERBOOK_BOOK_BACKEND=BookBackend::Ladder
+#ifndef ORDERBOOK_BOOK_BACKEND
+#define ORDERBOOK_BOOK_BACKEND BookBackend::Ladder
+#endif
+
+// every backend is built by make(tick_size), iterates best price first and answers two neighbour
+// queries:
+// level_worse_than(side, price) / level_better_than(side, price) return the closest level
+// strictly worse / better than `price` (which need not be in the book), nullptr if none.
+template<bool Side, BookBackend Backend = ORDERBOOK_BOOK_BACKEND>
+struct BookSide {
+};
+
+template<bool Side>
+struct BookSide<Side, BookBackend::Map> {
+    using MapType = std::map<int32_t, Limit *, std::conditional_t<Side, std::greater<>, std::less<>>>;
+    static constexpr bool is_bid = Side;
+
+    static MapType make(int32_t) { return MapType(); }
+
+    static Limit *level_worse_than(const MapType &side, int32_t price) {
+        auto it = side.upper_bound(price);
+        return it != side.end() ? it->second : nullptr;
+    }
+
+    static Limit *level_better_than(const MapType &side, int32_t price) {
+        auto it = side.lower_bound(price);
+        return it != side.begin() ? std::prev(it)->second : nullptr;
+    }
+};
+
+template<bool Side>
+struct BookSide<Side, BookBackend::Ladder> {
+    using MapType = PriceLadder<Side>;
+    static constexpr bool is_bid = Side;
+
+    static MapType make(int32_t tick_size) { return MapType(tick_size); }
+
+    static Limit *level_worse_than(const MapType &side, int32_t price) { return side.level_worse_than(price); }
+
+    static Limit *level_better_than(const MapType &side, int32_t price) { return side.level_better_than(price); }
+};
+
+template<bool Side>
+struct BookSide<Side, BookBackend::Vector> {
+    using MapType = LevelVector<Side>;
+    static constexpr bool is_bid = Side;
+
+    static MapType make(int32_t) { return MapType(); }
+
+    static Limit *level_worse_than(const MapType &side, int32_t price) { return side.level_worse_than(price); }
+
+    static Limit *level_better_than(const MapType &side, int32_t price) { return side.level_better_than(price); }
+};
+
+#endif //DATABENTO_ORDERBOOK_BOOK_SIDE_H
@@ -0,0 +1,72 @@
+#ifndef DATABENTO_ORDERBOOK_CHECKPOINT_H
+#define DATABENTO_ORDERBOOK_CHECKPOINT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// on-disk book checkpoint: a header, then every price level (bids best -> worst, then asks
+// best -> worst), then every resting order grouped by level in queue order. all records are
+// fixed size and 8-byte aligned, so a mapped file is read in place as three arrays.
+struct CheckpointHeader {
+    char magic_[8];
+    uint32_t version_;
+    uint32_t level_count_;
+    uint64_t order_count_;
+    uint64_t message_index_; // caller's stream position: index of the next message to apply
+    uint64_t message_count_; // Orderbook::ct_
+    uint64_t last_time_;     // exchange time (ns) of the last applied message
+    double sum1_;
+    double sum2_;
+    double vwap_;
+};
+
+struct CheckpointLevel {
+    int32_t price_;
+    uint32_t order_count_;
+    uint8_t side_;
+    uint8_t pad_[7];
+};
+
+struct CheckpointOrder {
+    uint64_t id_;
+    uint64_t unix_time_;
+    uint32_t size_;
+    uint8_t filled_;
+    uint8_t pad_[3];
+};
+
+static_assert(sizeof(CheckpointHeader) % 8 == 0 && sizeof(CheckpointLevel) % 8 == 0 &&
+              sizeof(CheckpointOrder) % 8 == 0, "checkpoint records must keep 8-byte alignment");
+
+// read-only mapping of a checkpoint file. valid() is false if the file is missing, truncated
+// or has the wrong magic/version.
+class CheckpointView {
+public:
+    static constexpr char MAGIC[8] = {'O', 'B', 'C', 'K', 'P', 'T', '\0', '\0'};
+    static constexpr uint32_t VERSION = 1;
+
+    explicit CheckpointView(const std::string &path);
+
+    ~CheckpointView();
+
+    CheckpointView(const CheckpointView &) = delete;
+    CheckpointView &operator=(const CheckpointView &) = delete;
+
+    bool valid() const { return header_ != nullptr; }
+
+    const CheckpointHeader &header() const { return *header_; }
+
+    const CheckpointLevel *levels() const { return levels_; }
+
+    const CheckpointOrder *orders() const { return orders_; }
+
+private:
+    void *mapped_ = nullptr;
+    size_t size_ = 0;
+    const CheckpointHeader *header_ = nullptr;
+    const CheckpointLevel *levels_ = nullptr;
+    const CheckpointOrder *orders_ = nullptr;
+};
+
+#endif //DATABENTO_ORDERBOOK_CHECKPOINT_H
@@ -0,0 +1,88 @@
+#ifndef DATABENTO_ORDERBOOK_CSV_SCAN_H
+#define DATABENTO_ORDERBOOK_CSV_SCAN_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include "depth_kernels.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "csv_scan.h digit decoding assumes a little endian target"
+#endif
+
+// the tokenizer classifies 64 bytes at a time and may read up to CSV_PADDING bytes past the
+// last byte it is asked to parse (block tails and 8 byte digit loads), the parser only hands it
+// ranges with that much readable memory behind them
+constexpr size_t CSV_BLOCK = 64;
+constexpr size_t CSV_PADDING = 64;
+
+// separator masks over one CSV_BLOCK, bit i set when block[i] is a ',' or '\n'. same backend
+// selection as DepthKernels: x86 via cpuid, NEON when the target has it, ORDERBOOK_SIMD_SCALAR
+// forces the scalar loop
+struct CsvScanKernels {
+    SimdBackend backend;
+    const char *name;
+
+    // commas and newlines, newlines alone in `newlines`
+    uint64_t (*separators)(const char *block, uint64_t &newlines);
+};
+
+const CsvScanKernels &csv_scan_kernels();
+
+const CsvScanKernels *csv_scan_kernels_for(SimdBackend backend);
+
+// branch-light unsigned decimal decoding, eight digits per multiply chain (swar). reads 8 bytes
+// from the start of every 8 digit group, so `p + len + 8` must be readable. digits are not
+// validated, len above 19 is cut to its last 19 digits
+namespace csv {
+
+inline uint64_t load8(const char *p) {
+    uint64_t chunk;
+    std::memcpy(&chunk, p, sizeof(chunk));
+    return chunk;
+}
+
+// 8 ascii digits, first digit in the low byte
+inline uint32_t parse_eight(uint64_t chunk) {
+    chunk -= 0x3030303030303030ULL;
+    chunk = chunk * 10 + (chunk >> 8);
+    chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+             (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    return static_cast<uint32_t>(chunk);
+}
+
+// 0 to 8 digits, left padded with '0' inside the register
+inline uint32_t parse_short(const char *p, size_t len) {
+    if (len == 0) {
+        return 0;
+    }
+    unsigned shift = static_cast<unsigned>(8 - len) * 8;
+    uint64_t chunk = load8(p) << shift;
+    chunk |= 0x3030303030303030ULL & ~(~0ULL << shift);
+    return parse_eight(chunk);
+}
+
+inline uint64_t parse_uint(const char *p, size_t len) {
+    if (len <= 8) {
+        return parse_short(p, len);
+    }
+    if (len <= 16) {
+        return parse_short(p, len - 8) * 100000000ULL + parse_eight(load8(p + len - 8));
+    }
+    if (len > 19) {
+        p += len - 19;
+        len = 19;
+    }
+    return parse_short(p, len - 16) * 10000000000000000ULL + parse_eight(load8(p + len - 16)) * 100000000ULL +
+           parse_eight(load8(p + len - 8));
+}
+
+inline int64_t parse_int(const char *p, size_t len) {
+    bool negative = len > 0 && *p == '-';
+    uint64_t magnitude = parse_uint(p + negative, len - negative);
+    return negative ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude);
+}
+
+}
+
+#endif //DATABENTO_ORDERBOOK_CSV_SCAN_H
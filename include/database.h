@@ -61,9 +61,8 @@ public:
 
     void send_line_protocol_tcp(const std::string &line_protocol);
 
-    template<typename BidCompare, typename AskCompare>
-    inline void update_limit_orderbook(const std::map<int32_t, Limit *, BidCompare> &bids,
-                                       const std::map<int32_t, Limit *, AskCompare> &offers) {
+    template<typename BidSide, typename AskSide>
+    inline void update_limit_orderbook(const BidSide &bids, const AskSide &offers) {
         OrderBookUpdate update;
         update.timestamp_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
                 std::chrono::system_clock::now().time_since_epoch()).count();
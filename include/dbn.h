@@ -0,0 +1,186 @@
+#ifndef DATABENTO_ORDERBOOK_DBN_H
+#define DATABENTO_ORDERBOOK_DBN_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "message.h"
+#include "message_source.h"
+
+class Orderbook;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "the dbn reader loads little-endian fields straight from the mapping"
+#endif
+
+// uncompressed databento binary encoding (DBN v1 to v3). the file is a "DBN" + version prefix,
+// a u32 metadata length, the metadata, then records back to back. every record starts with a
+// 16 byte header whose first byte is its length in 4 byte words, so records of other types
+// (or with ts_out appended) are stepped over without being decoded
+namespace dbn {
+
+constexpr uint8_t RTYPE_MBO = 0xA0;
+constexpr uint16_t SCHEMA_MBO = 0;
+constexpr uint16_t SCHEMA_MIXED = 0xFFFF;
+constexpr int64_t UNDEF_PRICE = INT64_MAX;
+constexpr size_t HEADER_BYTES = 16;
+constexpr size_t MBO_BYTES = 56;
+
+template<typename T>
+inline T load(const uint8_t* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+}
+
+// one MboMsg read in place from the mapping, nothing is copied until a field is asked for
+class DbnMboView {
+public:
+    explicit DbnMboView(const uint8_t* record) : record_(record) {}
+
+    uint32_t instrument_id() const { return dbn::load<uint32_t>(record_ + 4); }
+    uint64_t ts_event() const { return dbn::load<uint64_t>(record_ + 8); }
+    uint64_t order_id() const { return dbn::load<uint64_t>(record_ + 16); }
+    // 1e-9 units, dbn::UNDEF_PRICE when there is none
+    int64_t price() const { return dbn::load<int64_t>(record_ + 24); }
+    uint32_t size() const { return dbn::load<uint32_t>(record_ + 32); }
+    uint8_t flags() const { return record_[36]; }
+    uint8_t channel_id() const { return record_[37]; }
+    char action() const { return static_cast<char>(record_[38]); }
+    char side() const { return static_cast<char>(record_[39]); }
+    uint64_t ts_recv() const { return dbn::load<uint64_t>(record_ + 40); }
+    int32_t ts_in_delta() const { return dbn::load<int32_t>(record_ + 48); }
+    uint32_t sequence() const { return dbn::load<uint32_t>(record_ + 52); }
+
+private:
+    const uint8_t* record_;
+};
+
+// dbn prices are fixed point with 1e-9 units, the book works in int32 steps of divisor_ of
+// those. hundredths() matches the csv exports (5291.25 -> 529125), ticks() counts whole ticks.
+// the Orderbook tick_size follows: Orderbook::ES_TICK_SIZE for hundredths(), 1 for ticks()
+struct DbnPriceScale {
+    int64_t divisor_ = 10'000'000;
+
+    static DbnPriceScale hundredths() { return DbnPriceScale{10'000'000}; }
+
+    // e.g. ticks(250'000'000) for the 0.25 ES tick
+    static DbnPriceScale ticks(int64_t tick_size) { return DbnPriceScale{tick_size}; }
+
+    // undefined prices (market orders, clears) become 0
+    int32_t to_book(int64_t price) const {
+        return price == dbn::UNDEF_PRICE ? 0 : static_cast<int32_t>(price / divisor_);
+    }
+};
+
+inline message to_message(const DbnMboView& mbo, const DbnPriceScale& scale) {
+    return message(mbo.order_id(), mbo.ts_event(), mbo.size(), scale.to_book(mbo.price()), mbo.action(),
+                   mbo.side() == 'B', mbo.instrument_id(), mbo.flags(), mbo.sequence());
+}
+
+// a memory-mapped uncompressed dbn file. only MBO records are handed out, optionally only
+// those of one instrument
+class DbnFile {
+public:
+    explicit DbnFile(const std::string& file_path, uint32_t instrument_id = 0);
+    ~DbnFile();
+
+    DbnFile(const DbnFile&) = delete;
+    DbnFile& operator=(const DbnFile&) = delete;
+
+    // false if the file could not be mapped or is not an uncompressed mbo dbn file
+    bool is_open() const { return records_ != nullptr; }
+
+    uint8_t version() const { return version_; }
+    uint16_t schema() const { return schema_; }
+    const std::string& dataset() const { return dataset_; }
+
+    const uint8_t* records_begin() const { return records_; }
+    const uint8_t* records_end() const { return end_; }
+
+    // calls f(DbnMboView) for every mbo record from `position` on, stops early at `limit`
+    // records and returns where it stopped
+    template<typename F>
+    const uint8_t* for_each_mbo(const uint8_t* position, size_t limit, F&& f) const {
+        size_t seen = 0;
+        while (seen < limit && end_ - position >= static_cast<ptrdiff_t>(dbn::HEADER_BYTES)) {
+            const size_t length = static_cast<size_t>(position[0]) * 4;
+            if (length < dbn::HEADER_BYTES || length > static_cast<size_t>(end_ - position)) {
+                report_truncated(position);
+                return end_;
+            }
+            if (position[1] == dbn::RTYPE_MBO && length >= dbn::MBO_BYTES &&
+                (instrument_id_ == 0 || dbn::load<uint32_t>(position + 4) == instrument_id_)) {
+                f(DbnMboView(position));
+                ++seen;
+            }
+            position += length;
+        }
+        return position;
+    }
+
+    template<typename F>
+    size_t for_each_mbo(F&& f) const {
+        size_t count = 0;
+        for_each_mbo(records_, SIZE_MAX, [&](const DbnMboView& mbo) {
+            f(mbo);
+            ++count;
+        });
+        return count;
+    }
+
+    // straight from the mapping into the book, one message on the stack per record
+    size_t replay(Orderbook& book, const DbnPriceScale& scale = {}) const;
+
+    // the whole file as messages, for the random access paths (checkpoints, sweeps)
+    std::vector<message> to_messages(const DbnPriceScale& scale = {}) const;
+
+private:
+    std::string file_path_;
+    uint32_t instrument_id_;
+    uint8_t* mapped_file_ = nullptr;
+    size_t file_size_ = 0;
+    const uint8_t* records_ = nullptr;
+    const uint8_t* end_ = nullptr;
+    uint8_t version_ = 0;
+    uint16_t schema_ = 0;
+    std::string dataset_;
+
+    bool read_metadata();
+    void report_truncated(const uint8_t* position) const;
+};
+
+// replays a dbn file through the MessageSource interface. refill() converts the next BATCH
+// mbo records into a fixed buffer straight from the mapping, there is no parse step to wait
+// for and nothing to hold besides the page cache
+class DbnSource : public MessageSource {
+public:
+    static constexpr size_t BATCH = 4096;
+
+    explicit DbnSource(const std::string& file_path, uint32_t instrument_id = 0,
+                       const DbnPriceScale& scale = {});
+
+    bool is_open() const { return file_.is_open(); }
+
+    size_t size() const override { return 0; }
+
+    double progress() const override;
+
+    void rewind() override;
+
+protected:
+    bool refill() override;
+
+private:
+    DbnFile file_;
+    DbnPriceScale scale_;
+    const uint8_t* position_;
+    size_t read_ = 0;
+    std::vector<message> batch_;
+};
+
+#endif //DATABENTO_ORDERBOOK_DBN_H
@@ -0,0 +1,86 @@
+#ifndef DATABENTO_ORDERBOOK_DEPTH_AGGREGATE_H
+#define DATABENTO_ORDERBOOK_DEPTH_AGGREGATE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include "limit.h"
+
+// cumulative volume over the best `Levels` price levels of one book side, kept exact
+// incrementally. the window is described by its worst price (boundary_): a level is inside
+// it iff it is not worse than the boundary, or the side has at most `Levels` levels.
+// volume changes inside the window are O(1); a level entering or leaving the window swaps
+// one level in or out through the backend's neighbour queries (see BookSide).
+// the book must report every level insert/erase and every volume change on that side.
+template<typename Book, size_t Levels>
+class DepthAggregate {
+public:
+    using MapType = typename Book::MapType;
+    using Compare = std::conditional_t<Book::is_bid, std::greater<>, std::less<>>;
+
+    static_assert(Levels > 0, "depth window needs at least one level");
+
+    static constexpr size_t depth() { return Levels; }
+
+    int64_t volume() const { return volume_; }
+
+    size_t levels() const { return count_; }
+
+    inline bool in_window(int32_t price) const {
+        return count_ <= Levels || !Compare{}(boundary_, price);
+    }
+
+    inline void on_volume(int32_t price, int64_t delta) {
+        if (in_window(price)) {
+            volume_ += delta;
+        }
+    }
+
+    // `price` was just inserted into `side` as a new, still empty level
+    void on_level_added(const MapType &side, int32_t price) {
+        ++count_;
+        if (count_ <= Levels) {
+            if (count_ == 1 || Compare{}(boundary_, price)) {
+                boundary_ = price;
+            }
+            return;
+        }
+        if (Compare{}(boundary_, price)) {
+            return;
+        }
+        // the new level pushes the current boundary level out of the window
+        volume_ -= static_cast<int64_t>(side.find(boundary_)->second->volume_);
+        boundary_ = Book::level_better_than(side, boundary_)->price_;
+    }
+
+    // `price` was just erased from `side`, its remaining volume already went through on_volume
+    void on_level_removed(const MapType &side, int32_t price) {
+        bool was_in_window = in_window(price);
+        --count_;
+        if (!was_in_window) {
+            return;
+        }
+        if (count_ >= Levels) {
+            // the best level outside the window moves in
+            Limit *next = Book::level_worse_than(side, boundary_);
+            volume_ += static_cast<int64_t>(next->volume_);
+            boundary_ = next->price_;
+        } else if (price == boundary_ && count_ > 0) {
+            boundary_ = Book::level_better_than(side, price)->price_;
+        }
+    }
+
+    void clear() {
+        volume_ = 0;
+        count_ = 0;
+        boundary_ = 0;
+    }
+
+private:
+    int64_t volume_ = 0;
+    size_t count_ = 0;
+    int32_t boundary_ = 0;
+};
+
+#endif //DATABENTO_ORDERBOOK_DEPTH_AGGREGATE_H
@@ -0,0 +1,38 @@
+#ifndef DATABENTO_ORDERBOOK_DEPTH_KERNELS_H
+#define DATABENTO_ORDERBOOK_DEPTH_KERNELS_H
+
+#include <cstdint>
+#include <cstddef>
+
+enum class SimdBackend {
+    Scalar,
+    SSE42,
+    AVX2,
+    NEON
+};
+
+// vectorised depth statistics over contiguous per-level volume arrays (index 0 = touch).
+// x86 backends are compiled with per-function target attributes and picked at runtime from
+// cpuid, NEON is used whenever the target has it. define ORDERBOOK_SIMD_SCALAR to force the
+// scalar path. volumes (and their running sums) are expected to stay below 2^31.
+struct DepthKernels {
+    SimdBackend backend;
+    const char *name;
+
+    // sum of volumes[i] * weights[i]
+    double (*weighted_sum)(const uint32_t *volumes, const double *weights, size_t n);
+
+    // out[i] = volumes[0] + ... + volumes[i], out may alias volumes
+    void (*cumulative)(const uint32_t *volumes, uint32_t *out, size_t n);
+
+    // out[i] = (bid[i] - ask[i]) / (bid[i] + ask[i]), 0 where both are 0
+    void (*imbalance)(const uint32_t *bid, const uint32_t *ask, double *out, size_t n);
+};
+
+// fastest backend available on this build and cpu, resolved once
+const DepthKernels &depth_kernels();
+
+// a specific backend, nullptr if it is not compiled in or the cpu lacks it
+const DepthKernels *depth_kernels_for(SimdBackend backend);
+
+#endif //DATABENTO_ORDERBOOK_DEPTH_KERNELS_H
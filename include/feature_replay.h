@@ -0,0 +1,36 @@
+#ifndef DATABENTO_ORDERBOOK_FEATURE_REPLAY_H
+#define DATABENTO_ORDERBOOK_FEATURE_REPLAY_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "bbo.h"
+#include "orderbook.h"
+#include "message.h"
+#include "database.h"
+
+// book state at the end of one second of exchange time, one row per second with messages
+struct SecondFeatures {
+    uint64_t second_;         // exchange time in whole seconds since epoch
+    Bbo bbo_;
+    int32_t mid_price_;
+    int32_t voi_;             // order_imbalance() against the previous row
+    double imbalance_;        // over the top DEPTH_LEVELS levels
+    int32_t bid_vol_;
+    int32_t ask_vol_;
+    uint64_t message_count_;  // messages applied so far
+};
+
+// per-second features of a whole day, reconstructed in parallel. the stream is cut into
+// `threads` chunks at snapshots of the SnapshotIndex in `index_dir` (built first if it is
+// missing or was built from another stream), each chunk restores its starting book and is
+// replayed on its own thread. rows are only taken between exchange events, and a second split
+// by a chunk boundary keeps the later chunk's row, so the stitched rows are identical to a
+// single threaded replay.
+// threads <= 1 replays serially from the start without touching the index.
+std::vector<SecondFeatures> extract_second_features(DatabaseManager &db_manager, const std::vector<message> &messages,
+                                                    const std::string &index_dir, size_t threads,
+                                                    uint32_t index_interval_seconds = 60);
+
+#endif //DATABENTO_ORDERBOOK_FEATURE_REPLAY_H
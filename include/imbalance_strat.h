@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include "strategy.h"
+
+struct ImbalanceParams {
+    size_t depth_ = Orderbook::DEPTH_LEVELS;  // levels per side the imbalance is taken over
+    double threshold_ = 0.0;                  // |imbalance| above which it trades
+};
+
+class ImbalanceStrat : public Strategy {
+private:
+    double imbalance_mean_ = 0.0;
+    double imbalance_variance_ = 0.0;
+    int update_count_ = 0;
+    const int WARMUP_PERIOD = 1000;
+    ImbalanceParams params_;
+    std::vector<double> depth_imbalance_;
+
+protected:
+    bool req_fitting = false;
+
+    void fit_model() override {}
+
+    void update_theo_values() override;
+
+    void calculate_pnl() override;
+
+    void log_stats(const Orderbook &book) override;
+
+    double imbalance();
+
+public:
+    explicit ImbalanceStrat(DatabaseManager &db_manager, Orderbook *book,
+                            const ImbalanceParams &params = ImbalanceParams{},
+                            const std::string &log_file_name = "imbalance_strat_log.csv");
+
+    void on_book_update() override;
+
+    void execute_trade(bool is_buy, int32_t price, int size) override;
+
+    void reset() override;
+
+    const ImbalanceParams &params() const { return params_; }
+};
@@ -0,0 +1,115 @@
+#ifndef DATABENTO_ORDERBOOK_LEVEL_VECTOR_H
+#define DATABENTO_ORDERBOOK_LEVEL_VECTOR_H
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "limit.h"
+
+// one side of the book as a std::vector of (price, Limit*) kept sorted worst -> best, so the
+// touch sits at back(). most adds/cancels land within a few levels of the touch, which makes
+// insert/erase shift only a handful of elements. searches scan a few slots back from the
+// touch and fall back to a binary search for levels deep in the book.
+// iteration order matches std::map with the side's comparator: best price first.
+template<bool Side>
+class LevelVector {
+public:
+    using Compare = std::conditional_t<Side, std::greater<>, std::less<>>;
+    using value_type = std::pair<int32_t, Limit *>;
+    using Storage = std::vector<value_type>;
+    using const_iterator = typename Storage::const_reverse_iterator;
+    using iterator = const_iterator;
+
+    explicit LevelVector(size_t capacity = 1024) {
+        levels_.reserve(capacity);
+    }
+
+    const_iterator begin() const { return levels_.crbegin(); }
+
+    const_iterator end() const { return levels_.crend(); }
+
+    bool empty() const { return levels_.empty(); }
+
+    size_t size() const { return levels_.size(); }
+
+    const value_type &best() const { return levels_.back(); }
+
+    const_iterator find(int32_t price) const {
+        auto it = lower_bound(price);
+        if (it == levels_.end() || it->first != price) {
+            return end();
+        }
+        return const_iterator(it + 1);
+    }
+
+    bool emplace(int32_t price, Limit *limit) {
+        auto it = lower_bound(price);
+        if (it != levels_.end() && it->first == price) {
+            return false;
+        }
+        levels_.emplace(it, price, limit);
+        return true;
+    }
+
+    size_t erase(int32_t price) {
+        auto it = lower_bound(price);
+        if (it == levels_.end() || it->first != price) {
+            return 0;
+        }
+        levels_.erase(it);
+        return 1;
+    }
+
+    void clear() { levels_.clear(); }
+
+    // closest level strictly worse than `price`, nullptr if none
+    Limit *level_worse_than(int32_t price) const {
+        size_t idx = lower_bound_index(price);
+        return idx > 0 ? levels_[idx - 1].second : nullptr;
+    }
+
+    // closest level strictly better than `price`, nullptr if none
+    Limit *level_better_than(int32_t price) const {
+        size_t idx = lower_bound_index(price);
+        if (idx < levels_.size() && levels_[idx].first == price) {
+            ++idx;
+        }
+        return idx < levels_.size() ? levels_[idx].second : nullptr;
+    }
+
+private:
+    static constexpr size_t LINEAR_SCAN_ = 16;
+
+    Storage levels_;
+
+    // first element (from the front) whose price is not worse than `price`
+    typename Storage::iterator lower_bound(int32_t price) {
+        return levels_.begin() + lower_bound_index(price);
+    }
+
+    typename Storage::const_iterator lower_bound(int32_t price) const {
+        return levels_.begin() + lower_bound_index(price);
+    }
+
+    inline size_t lower_bound_index(int32_t price) const {
+        size_t idx = levels_.size();
+        size_t scanned = 0;
+        while (idx > 0 && !Compare{}(price, levels_[idx - 1].first)) {
+            --idx;
+            if (++scanned == LINEAR_SCAN_) {
+                auto it = std::partition_point(levels_.begin(), levels_.begin() + idx,
+                                               [price](const value_type &level) {
+                                                   return Compare{}(price, level.first);
+                                               });
+                return it - levels_.begin();
+            }
+        }
+        return idx;
+    }
+};
+
+#endif //DATABENTO_ORDERBOOK_LEVEL_VECTOR_H
@@ -1,84 +1,81 @@
-
 #ifndef DATABENTO_ORDERBOOK_LIMIT_H
 #define DATABENTO_ORDERBOOK_LIMIT_H
 
 #include <cstdint>
 #include "order.h"
+#include "order_pool.h"
 
 class Limit {
 public:
-    explicit Limit(Order* new_order);
     Limit(int32_t price);
+    Limit();
 
     int32_t price_;
     uint64_t volume_;
     uint32_t num_orders_;
-    Order* head_;
-    Order* tail_;
+    union {
+        uint32_t head_;
+        uint32_t next_free_; // only used while the limit sits in LimitPool's free list
+    };
+    uint32_t tail_;
+    uint32_t handle_; // slot in the owning LimitPool, what orders store as parent_
     uint64_t total_volume() { return volume_; }
     bool side_;
 
-    inline void add_order(Order* new_order) {
-        if (head_ == nullptr && tail_ == nullptr) {
-            head_ = new_order;
-            tail_ = new_order;
+    inline void add_order(uint32_t handle, OrderPool& pool) {
+        Order* new_order = pool.at(handle);
+        if (head_ == Order::NULL_ORDER) {
+            head_ = handle;
+            new_order->prev_ = Order::NULL_ORDER;
         } else {
-            tail_->next_ = new_order;
+            pool.at(tail_)->next_ = handle;
             new_order->prev_ = tail_;
-            tail_ = tail_->next_;
-            tail_->next_ = nullptr;
         }
+        tail_ = handle;
+        new_order->next_ = Order::NULL_ORDER;
+
         volume_ += new_order->size;
         ++num_orders_;
-        new_order->parent_ = this;
+        new_order->parent_ = handle_;
     }
 
-    inline void remove_order(Order* target) {
-        if (!target || !head_) {
-            // Log an error or throw an exception
+    inline void remove_order(uint32_t handle, OrderPool& pool) {
+        if (handle == Order::NULL_ORDER || head_ == Order::NULL_ORDER) {
             return;
         }
 
+        Order* target = pool.at(handle);
         volume_ -= target->size;
         --num_orders_;
 
-        if (head_ == tail_ && head_ == target) {
-            head_ = nullptr;
-            tail_ = nullptr;
-        }
-        else if (head_ == target) {
-            head_ = head_->next_;
-            if (head_) {
-                head_->prev_ = nullptr;
-            }
-        }
-        else if (tail_ == target) {
-            tail_ = tail_->prev_;
-            if (tail_) {
-                tail_->next_ = nullptr;
-            }
+        if (target->prev_ != Order::NULL_ORDER) {
+            pool.at(target->prev_)->next_ = target->next_;
+        } else {
+            head_ = target->next_;
         }
-        else {
-            if (target->prev_) {
-                target->prev_->next_ = target->next_;
-            }
-            if (target->next_) {
-                target->next_->prev_ = target->prev_;
-            }
+
+        if (target->next_ != Order::NULL_ORDER) {
+            pool.at(target->next_)->prev_ = target->prev_;
+        } else {
+            tail_ = target->prev_;
         }
 
-        target->next_ = nullptr;
-        target->prev_ = nullptr;
-        target->parent_ = nullptr;
+        target->next_ = Order::NULL_ORDER;
+        target->prev_ = Order::NULL_ORDER;
+        target->parent_ = Order::NULL_ORDER;
     }
 
     int32_t get_price();
+
     uint64_t get_volume();
+
     uint32_t get_size();
+
     bool is_empty();
+
     void reset();
+
     void set(int32_t price);
 };
 
-
 #endif //DATABENTO_ORDERBOOK_LIMIT_H
@@ -1,24 +1,55 @@
-
-/*
 #ifndef DATABENTO_ORDERBOOK_LIMIT_POOL_H
 #define DATABENTO_ORDERBOOK_LIMIT_POOL_H
 
-#include <unordered_map>
-#include <list>
+#include <cstdint>
 #include <memory>
-#include "Limit.h"
-
+#include <vector>
+#include "limit.h"
 
-class limit_pool {
+// hands out Limit objects carved from contiguous slabs. released limits are pushed onto an
+// intrusive free list threaded through Limit::next_free_, so once the pool has grown to the
+// peak number of live price levels it never touches the heap again. every limit keeps a fixed
+// 32-bit handle that orders store as their parent_.
+class LimitPool {
 private:
-    std::unordered_map<float,std::unique_ptr<Limit>> limits_by_price_;
+    static constexpr uint32_t SLAB_BITS = 10;
+    static constexpr uint32_t SLAB_SIZE = 1u << SLAB_BITS;
+    static constexpr uint32_t SLAB_MASK = SLAB_SIZE - 1;
+
+    std::vector<std::unique_ptr<Limit[]>> slabs_;
+    uint32_t free_list_;
+
+    void add_slab();
 
 public:
-    Limit* acquire_limit(float price);
-    void release_limit(Limit* curr);
-    //~limit_pool();
-};
+    explicit LimitPool(size_t initial_size);
 
+    inline Limit* get_limit(int32_t price) {
+        if (free_list_ == Order::NULL_ORDER) {
+            add_slab();
+        }
+        Limit* limit = at(free_list_);
+        free_list_ = limit->next_free_;
+
+        limit->price_ = price;
+        limit->volume_ = 0;
+        limit->num_orders_ = 0;
+        limit->head_ = Order::NULL_ORDER;
+        limit->tail_ = Order::NULL_ORDER;
+        return limit;
+    }
+
+    inline void return_limit(Limit* limit) {
+        limit->next_free_ = free_list_;
+        free_list_ = limit->handle_;
+    }
+
+    inline Limit* at(uint32_t handle) const {
+        return &slabs_[handle >> SLAB_BITS][handle & SLAB_MASK];
+    }
+
+    // makes every slab available again without releasing memory
+    void reset();
+};
 
 #endif //DATABENTO_ORDERBOOK_LIMIT_POOL_H
-*/
\ No newline at end of file
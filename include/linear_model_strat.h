@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include "strategy.h"
+#include "orderbook.h"
+
+struct LinearModelParams {
+    int max_lag_ = 5;              // voi lags in the regression
+    int forecast_window_ = 300;    // seconds of mid price change it predicts
+    double threshold_ = 20;        // predicted change that triggers a trade
+};
+
+class LinearModelStrategy : public Strategy {
+protected:
+    static constexpr int TRADE_SIZE_ = 1;
+
+    LinearModelParams params_;
+    std::vector<double> model_coefficients_;
+    double fees_ = 0.0;
+
+    double predict_price_change() const;
+
+    void update_theo_values() override;
+
+    void calculate_pnl() override;
+
+    void log_stats(const Orderbook& book) override;
+
+public:
+
+    bool req_fitting = true;
+
+    explicit LinearModelStrategy(DatabaseManager& db_manager, Orderbook* book,
+                                 const LinearModelParams& params = LinearModelParams{},
+                                 const std::string& log_file_name = "linear_model_strategy_log.csv");
+
+    void execute_trade(bool is_buy, int32_t price, int32_t trade_size) override;
+
+    void on_book_update() override;
+
+    void reset() override;
+
+    void fit_model() override;
+
+    const LinearModelParams& params() const { return params_; }
+};
@@ -3,50 +3,48 @@
 
 #include <atomic>
 #include <array>
+#include <new>
 #include <optional>
 #include <type_traits>
 
+// single producer / single consumer ring. head_ and tail_ live on separate cache lines and each
+// side keeps a private copy of the other side's index, so the shared line is only re-read when
+// the ring looks full (producer) or empty (consumer).
 template <typename T, size_t SIZE>
 class LockFreeQueue {
 private:
-    struct Node {
-        std::atomic<bool> written{false};
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct Slot {
         alignas(T) unsigned char storage[sizeof(T)];
+    };
 
-        Node() noexcept : written(false) {}
-        ~Node() {
-            if (written.load()) {
-                reinterpret_cast<T*>(storage)->~T();
-            }
-        }
+    std::array<Slot, SIZE> buffer_;
 
-        Node(const Node&) = delete;
-        Node& operator=(const Node&) = delete;
-    };
+    // consumer side
+    alignas(CACHE_LINE) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;
+
+    // producer side
+    alignas(CACHE_LINE) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;
 
-    std::array<Node, SIZE> buffer_;
-    std::atomic<size_t> head_{0};
-    std::atomic<size_t> tail_{0};
+    T *slot(size_t index) {
+        return std::launder(reinterpret_cast<T *>(buffer_[index].storage));
+    }
 
 public:
     LockFreeQueue() = default;
 
     ~LockFreeQueue() {
-        size_t current_head = head_.load();
-        size_t current_tail = tail_.load();
+        size_t current_head = head_.load(std::memory_order_relaxed);
+        size_t current_tail = tail_.load(std::memory_order_acquire);
 
         while (current_head != current_tail) {
-            Node& node = buffer_[current_head];
-            if (node.written.load()) {
-                // call destructor of original element
-                reinterpret_cast<T*>(node.storage)->~T();
-                node.written.store(false);
-            }
+            // call destructor of original element
+            slot(current_head)->~T();
             current_head = (current_head + 1) % SIZE;
         }
-
-        head_.store(0);
-        tail_.store(0);
     }
 
     LockFreeQueue(const LockFreeQueue&) = delete;
@@ -54,51 +52,51 @@ public:
 
     template<typename U>
     bool enqueue(U&& item) {
-
-        size_t curr_tail = tail_.load();
+        size_t curr_tail = tail_.load(std::memory_order_relaxed);
         size_t next_tail = (curr_tail + 1) % SIZE;
 
-        // queue is full
-        if (next_tail == head_.load()) {
-            return false;
+        // queue looks full, refresh the consumer's position before giving up
+        if (next_tail == cached_head_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (next_tail == cached_head_) {
+                return false;
+            }
         }
 
         // use placement new to construct a new T object at the location of curr_tail.storage
         // std::forward preserves the value of the arg (lval/rval)
         new (buffer_[curr_tail].storage) T(std::forward<U>(item));
-        buffer_[curr_tail].written.store(true);
-        tail_.store(next_tail);
+        tail_.store(next_tail, std::memory_order_release);
 
         return true;
     }
 
     std::optional<T> dequeue() {
-        size_t curr_head = head_.load();
-        // queue is full
-        if (curr_head == tail_.load()) {
-            return std::nullopt;
-        }
-        // data not written yet
-        if (!buffer_[curr_head].written.load()) {
-            return std::nullopt;
+        size_t curr_head = head_.load(std::memory_order_relaxed);
+        // queue looks empty, refresh the producer's position before giving up
+        if (curr_head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (curr_head == cached_tail_) {
+                return std::nullopt;
+            }
         }
         // use std move to produce an rval ref, which is used for move/copy constructor of T
-        std::optional<T> result(std::move(*reinterpret_cast<T*>(buffer_[curr_head].storage)));
+        T *item = slot(curr_head);
+        std::optional<T> result(std::move(*item));
         // call destructor of T to completely delete the object
-        reinterpret_cast<T*>(buffer_[curr_head].storage)->~T();
-        buffer_[curr_head].written.store(false);
-        head_.store((curr_head + 1) % SIZE);
+        item->~T();
+        head_.store((curr_head + 1) % SIZE, std::memory_order_release);
 
         return result;
     }
 
     bool empty() const {
-        return head_.load() == tail_.load();
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
     }
 
     size_t size() const {
-        size_t head = head_.load();
-        size_t tail = tail_.load();
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
         if (tail >= head) {
             return tail - head;
         } else {
@@ -111,4 +109,4 @@ public:
     }
 };
 
-#endif 
+#endif
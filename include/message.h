@@ -1,17 +1,60 @@
-
 #ifndef DATABENTO_ORDERBOOK_MESSAGE_H
 #define DATABENTO_ORDERBOOK_MESSAGE_H
 #include <cstdint>
+#include <cstddef>
+#include <vector>
 struct message {
+    // databento record flags
+    static constexpr uint8_t F_LAST = 1 << 7;           // last record of an exchange event
+    static constexpr uint8_t F_TOB = 1 << 6;            // top of book message
+    static constexpr uint8_t F_SNAPSHOT = 1 << 5;       // replayed from a book snapshot
+    static constexpr uint8_t F_MBP = 1 << 4;            // aggregated price level message
+    static constexpr uint8_t F_BAD_TS_RECV = 1 << 3;
+    static constexpr uint8_t F_MAYBE_BAD_BOOK = 1 << 2;
+
     uint64_t id_;
     uint64_t time_;
     uint32_t size_;
     int32_t price_;
+    uint32_t instrument_id_;
+    uint32_t sequence_;
     char action_;
     bool side_;
+    uint8_t flags_;
+    uint8_t reserved_[5];   // the tail padding, zeroed so cached and checksummed records are deterministic
+
+    // fields are left uninitialised, for presized buffers that are then filled in place
+    message() {}
+
+    // without flags every message is treated as a complete event
+    message(uint64_t id, uint64_t time, uint32_t size, int32_t price, char action, bool side,
+            uint32_t instrument_id = 0, uint8_t flags = F_LAST, uint32_t sequence = 0)
+            : id_(id), time_(time), size_(size), price_(price), instrument_id_(instrument_id), sequence_(sequence),
+              action_(action), side_(side), flags_(flags), reserved_{} {}
+
+    bool is_last() const { return flags_ & F_LAST; }
+};
+
+// read-only view of contiguous messages, a parsed vector or a mapped MessageCache. the
+// messages must outlive it
+class MessageSpan {
+public:
+    MessageSpan() = default;
+    MessageSpan(const message* data, size_t size) : data_(data), size_(size) {}
+    MessageSpan(const std::vector<message>& messages) : data_(messages.data()), size_(messages.size()) {}
+
+    const message* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const message* begin() const { return data_; }
+    const message* end() const { return data_ + size_; }
+    const message& operator[](size_t i) const { return data_[i]; }
+    const message& front() const { return data_[0]; }
+    const message& back() const { return data_[size_ - 1]; }
 
-    message(uint64_t id, uint64_t time, uint32_t size, int32_t price, char action, bool side)
-            : id_(id), time_(time), size_(size), price_(price), action_(action), side_(side) {}
+private:
+    const message* data_ = nullptr;
+    size_t size_ = 0;
 };
 
 #endif //DATABENTO_ORDERBOOK_MESSAGE_H
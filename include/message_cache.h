@@ -0,0 +1,75 @@
+#ifndef DATABENTO_ORDERBOOK_MESSAGE_CACHE_H
+#define DATABENTO_ORDERBOOK_MESSAGE_CACHE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "message.h"
+
+// on-disk replay cache of a parsed csv: a header, then the messages exactly as they sit in a
+// std::vector<message>, so a mapped file is read in place as one array.
+struct MessageCacheHeader {
+    char magic_[8];
+    uint32_t version_;
+    uint32_t record_size_;     // sizeof(message) of the writer, a changed layout is never read
+    uint64_t message_count_;
+    uint64_t source_size_;     // size and modification time of the csv the cache was made from
+    int64_t source_mtime_;
+    uint64_t checksum_;        // MessageCache::checksum of the records
+    uint32_t instrument_id_;   // passed to the Parser
+    uint32_t pad_;
+};
+
+static_assert(sizeof(MessageCacheHeader) % alignof(message) == 0, "cached messages must stay aligned");
+static_assert(std::is_trivially_copyable<message>::value, "cached messages are mapped, not constructed");
+static_assert(std::has_unique_object_representations<message>::value, "padding would be written and checksummed");
+
+// the messages of one csv, mapped from `<csv>.msgcache` next to it. the first run parses the
+// csv and writes the cache, later runs map it with the pages read ahead and skip the text
+// entirely. a cache whose csv has changed since, or that is from another version, layout or
+// instrument, or fails its checksum, is rebuilt.
+class MessageCache {
+public:
+    static constexpr char MAGIC[8] = {'O', 'B', 'M', 'S', 'G', 'C', 'C', 'H'};
+    static constexpr uint32_t VERSION = 1;
+
+    // es0604.csv -> es0604.csv.msgcache
+    static std::string cache_path(const std::string& csv_path);
+
+    // writes `messages` as the cache of `csv_path` through a temporary file renamed into place
+    static bool write(const std::string& csv_path, MessageSpan messages, uint32_t instrument_id = 0);
+
+    // four independent multiply-xor lanes over 8 byte words, fast enough to check on every load
+    static uint64_t checksum(const void* data, size_t bytes);
+
+    // maps the cache, or parses the csv on `threads` threads and writes the cache first. the
+    // csv may be deleted once its cache exists, the cache is then used as is
+    explicit MessageCache(const std::string& csv_path, size_t threads = 1, uint32_t instrument_id = 0);
+
+    ~MessageCache();
+
+    MessageCache(const MessageCache&) = delete;
+    MessageCache& operator=(const MessageCache&) = delete;
+
+    // empty if the csv could not be parsed either
+    MessageSpan messages() const { return messages_; }
+
+    // true if the messages were mapped from an existing cache without parsing
+    bool hit() const { return hit_; }
+
+private:
+    std::string csv_path_;
+    uint32_t instrument_id_;
+    void* mapped_ = nullptr;
+    size_t mapped_size_ = 0;
+    std::vector<message> parsed_;   // kept when the cache could not be written
+    MessageSpan messages_;
+    bool hit_ = false;
+
+    bool map();
+    void unmap();
+};
+
+#endif //DATABENTO_ORDERBOOK_MESSAGE_CACHE_H
@@ -0,0 +1,192 @@
+#ifndef DATABENTO_ORDERBOOK_MESSAGE_SOURCE_H
+#define DATABENTO_ORDERBOOK_MESSAGE_SOURCE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "message.h"
+#include "parser.h"
+#include "lock_free_queue.h"
+
+// a day of messages read front to back. sources hand out batches, next() walks the current one
+// inline and only calls refill() when it is used up, so the replay loop pays one virtual call
+// per batch rather than per message
+class MessageSource {
+public:
+    virtual ~MessageSource() = default;
+
+    // next message in stream order, nullptr at the end. valid until the next batch is fetched
+    const message* next() {
+        if (cursor_ == end_ && !fetch()) {
+            return nullptr;
+        }
+        return cursor_++;
+    }
+
+    // the unread rest of the current batch, fetching a new one if it is used up. 0 at the end
+    size_t peek_batch(const message*& first) {
+        if (cursor_ == end_ && !fetch()) {
+            return 0;
+        }
+        first = cursor_;
+        return end_ - cursor_;
+    }
+
+    // marks `count` messages of peek_batch() as read
+    void consume(size_t count) { cursor_ += count; }
+
+    // messages read so far
+    size_t position() const { return batch_start_ + (cursor_ - begin_); }
+
+    // true once next() has returned nullptr
+    bool exhausted() const { return exhausted_; }
+
+    // total message count when it is known up front, 0 for a stream
+    virtual size_t size() const = 0;
+
+    // fraction of the day read, 0 to 1
+    virtual double progress() const = 0;
+
+    // back to the first message
+    virtual void rewind() = 0;
+
+    // the whole day in memory when the source has random access, empty for a stream
+    virtual MessageSpan messages() const { return {}; }
+
+    // jumps to message `index`, random access sources only
+    virtual bool seek(size_t) { return false; }
+
+protected:
+    // sets the next batch with set_batch() or returns false at the end of the stream
+    virtual bool refill() = 0;
+
+    void set_batch(const message* first, size_t count, size_t batch_start) {
+        begin_ = cursor_ = first;
+        end_ = first + count;
+        batch_start_ = batch_start;
+        exhausted_ = false;
+    }
+
+    void clear_batch() {
+        begin_ = cursor_ = end_ = nullptr;
+        batch_start_ = 0;
+        exhausted_ = false;
+    }
+
+private:
+    const message* begin_ = nullptr;
+    const message* cursor_ = nullptr;
+    const message* end_ = nullptr;
+    size_t batch_start_ = 0;
+    bool exhausted_ = false;
+
+    bool fetch() {
+        size_t read = position();
+        if (exhausted_ || !refill()) {
+            begin_ = cursor_ = end_ = nullptr;
+            batch_start_ = read;
+            exhausted_ = true;
+            return false;
+        }
+        return true;
+    }
+};
+
+// a day held in memory, a parsed vector or a mapped MessageCache, read as one batch. the
+// messages must outlive it
+class VectorSource : public MessageSource {
+public:
+    explicit VectorSource(MessageSpan messages) : messages_(messages) { clear_batch(); }
+
+    size_t size() const override { return messages_.size(); }
+
+    double progress() const override {
+        return messages_.empty() ? 1.0 : static_cast<double>(position()) / messages_.size();
+    }
+
+    void rewind() override { clear_batch(); }
+
+    MessageSpan messages() const override { return messages_; }
+
+    bool seek(size_t index) override {
+        index = std::min(index, messages_.size());
+        set_batch(messages_.data() + index, messages_.size() - index, index);
+        return true;
+    }
+
+protected:
+    bool refill() override {
+        size_t index = position();
+        if (index >= messages_.size()) {
+            return false;
+        }
+        set_batch(messages_.data() + index, messages_.size() - index, index);
+        return true;
+    }
+
+private:
+    MessageSpan messages_;
+};
+
+// parses a csv on a producer thread while the consumer replays it. the file is read CHUNK_BYTES
+// at a time and every chunk's whole lines become one batch. batches cycle through a fixed ring
+// of RING_BATCHES buffers, two SPSC queues carry them to the consumer and back, so memory stays
+// at a few MB whatever the file size and the first batch is ready after one chunk
+class CsvStreamSource : public MessageSource {
+public:
+    static constexpr size_t CHUNK_BYTES = 1 << 20;
+    static constexpr size_t RING_BATCHES = 8;
+
+    explicit CsvStreamSource(const std::string& file_path, uint32_t instrument_id = 0);
+    ~CsvStreamSource() override;
+
+    CsvStreamSource(const CsvStreamSource&) = delete;
+    CsvStreamSource& operator=(const CsvStreamSource&) = delete;
+
+    // false if the file could not be opened, the source is then empty
+    bool is_open() const { return fd_ != -1; }
+
+    size_t size() const override { return 0; }
+
+    double progress() const override;
+
+    // stops the producer and starts reading the file again from the top
+    void rewind() override;
+
+protected:
+    bool refill() override;
+
+private:
+    struct Batch {
+        std::vector<message> messages_;
+        size_t count_ = 0;
+        uint64_t file_offset_ = 0;   // bytes of the file consumed once this batch is read
+    };
+    // one slot more than the batches plus the end of stream marker, enqueue never fails
+    using BatchQueue = LockFreeQueue<Batch*, RING_BATCHES + 2>;
+
+    std::string file_path_;
+    Parser parser_;
+    int fd_ = -1;
+    uint64_t file_size_ = 0;
+    uint64_t consumed_bytes_ = 0;
+    size_t consumed_messages_ = 0;
+
+    std::vector<Batch> batches_;
+    std::unique_ptr<BatchQueue> filled_;   // producer -> consumer, nullptr marks the end
+    std::unique_ptr<BatchQueue> free_;     // consumer -> producer
+    Batch* current_ = nullptr;
+    std::thread producer_;
+    std::atomic<bool> stop_{false};
+
+    void start();
+    void halt();
+    void produce();
+};
+
+#endif //DATABENTO_ORDERBOOK_MESSAGE_SOURCE_H
@@ -1,28 +1,32 @@
-
 #ifndef DATABENTO_ORDERBOOK_ORDER_H
 #define DATABENTO_ORDERBOOK_ORDER_H
 
 #include <cstdint>
-#include <string>
-#include <ctime>
-
-using std::string;
-
-class Limit;
 
+// hot part of a resting order: everything add/cancel/modify and the queue walk in
+// trade_order touch. links are 32-bit handles into the owning OrderPool (next_/prev_) and
+// LimitPool (parent_), NULL_ORDER terminates a queue.
 class Order {
 public:
-    Order(uint64_t order_id, int32_t price, uint32_t order_size, bool order_side, uint64_t order_unix_time);
+    static constexpr uint32_t NULL_ORDER = UINT32_MAX;
+
     Order();
-    uint64_t id_;
-    int32_t price_;
     uint32_t size;
+    uint32_t next_;
+    uint32_t prev_;
+    uint32_t parent_;
+    int32_t price_;
     bool side_;
-    uint64_t unix_time_;
-    Order* next_;
-    Order* prev_;
-    Limit* parent_;
     bool filled_;
 };
 
+// keep the hot struct at 24 bytes so a 64 byte line holds more than two orders
+static_assert(sizeof(Order) <= 24, "Order hot struct grew past its 24 byte budget");
+
+// cold part, stored in a parallel array at the same pool slot, only read for bookkeeping
+struct OrderInfo {
+    uint64_t id_;
+    uint64_t unix_time_;
+};
+
 #endif // DATABENTO_ORDERBOOK_ORDER_H
@@ -0,0 +1,229 @@
+#ifndef DATABENTO_ORDERBOOK_ORDER_MAP_H
+#define DATABENTO_ORDERBOOK_ORDER_MAP_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <sys/mman.h>
+
+// open-addressing hash table keyed by exchange order id. linear probing over a flat array of
+// (id, value) slots with fibonacci hashing, deletes use backward shifting so there are no
+// tombstones and probe lengths stay short under heavy add/cancel churn.
+// key 0 marks an empty slot, an order with id 0 lives in a dedicated side slot.
+// slot memory comes straight from mmap, optionally backed by huge pages.
+template<typename T>
+class OrderMap {
+public:
+    static_assert(std::is_trivially_copyable<T>::value, "OrderMap values must be trivially copyable");
+
+    struct Slot {
+        uint64_t first;
+        T second;
+    };
+
+    using iterator = Slot *;
+
+    explicit OrderMap(size_t capacity = 1024, bool huge_pages = false) : huge_pages_(huge_pages) {
+        allocate(slots_for(capacity));
+    }
+
+    ~OrderMap() {
+        release(slots_, mapped_bytes_);
+    }
+
+    OrderMap(const OrderMap &) = delete;
+    OrderMap &operator=(const OrderMap &) = delete;
+
+    iterator end() { return nullptr; }
+
+    size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    size_t capacity() const { return capacity_; }
+
+    inline iterator find(uint64_t key) {
+        if (key == EMPTY_KEY) {
+            return has_zero_ ? &zero_slot_ : end();
+        }
+        for (size_t i = home(key);; i = (i + 1) & mask_) {
+            Slot &slot = slots_[i];
+            if (slot.first == key) {
+                return &slot;
+            }
+            if (slot.first == EMPTY_KEY) {
+                return end();
+            }
+        }
+    }
+
+    // single probe find-or-insert. returns the slot for `key` and whether it was inserted.
+    inline std::pair<iterator, bool> try_emplace(uint64_t key, T value) {
+        if (key == EMPTY_KEY) {
+            if (has_zero_) {
+                return {&zero_slot_, false};
+            }
+            has_zero_ = true;
+            zero_slot_ = {key, value};
+            ++size_;
+            return {&zero_slot_, true};
+        }
+        if ((size_ + 1) * MAX_LOAD_DEN > capacity_ * MAX_LOAD_NUM) {
+            rehash(capacity_ * 2);
+        }
+        for (size_t i = home(key);; i = (i + 1) & mask_) {
+            Slot &slot = slots_[i];
+            if (slot.first == key) {
+                return {&slot, false};
+            }
+            if (slot.first == EMPTY_KEY) {
+                slot.first = key;
+                slot.second = value;
+                ++size_;
+                return {&slot, true};
+            }
+        }
+    }
+
+    inline void insert_or_assign(uint64_t key, T value) {
+        try_emplace(key, value).first->second = value;
+    }
+
+    // pulls the home slot of `key` towards the cache ahead of a find/erase
+    inline void prefetch(uint64_t key) const {
+        __builtin_prefetch(&slots_[home(key)]);
+    }
+
+    // backward-shift delete: pull later members of the probe run into the hole
+    inline void erase(iterator it) {
+        --size_;
+        if (it == &zero_slot_) {
+            has_zero_ = false;
+            return;
+        }
+        size_t hole = static_cast<size_t>(it - slots_);
+        for (size_t i = (hole + 1) & mask_;; i = (i + 1) & mask_) {
+            Slot &slot = slots_[i];
+            if (slot.first == EMPTY_KEY) {
+                break;
+            }
+            if (((i - home(slot.first)) & mask_) >= ((i - hole) & mask_)) {
+                slots_[hole] = slot;
+                hole = i;
+            }
+        }
+        slots_[hole].first = EMPTY_KEY;
+    }
+
+    inline size_t erase(uint64_t key) {
+        iterator it = find(key);
+        if (it == end()) {
+            return 0;
+        }
+        erase(it);
+        return 1;
+    }
+
+    void clear() {
+        std::memset(static_cast<void *>(slots_), 0, capacity_ * sizeof(Slot));
+        has_zero_ = false;
+        size_ = 0;
+    }
+
+    void reserve(size_t count) {
+        size_t wanted = slots_for(count);
+        if (wanted > capacity_) {
+            rehash(wanted);
+        }
+    }
+
+private:
+    static constexpr uint64_t EMPTY_KEY = 0;
+    static constexpr size_t MAX_LOAD_NUM = 1;
+    static constexpr size_t MAX_LOAD_DEN = 2;
+    static constexpr size_t MIN_CAPACITY = 16;
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    Slot *slots_ = nullptr;
+    size_t capacity_ = 0;
+    size_t mapped_bytes_ = 0;
+    size_t mask_ = 0;
+    unsigned shift_ = 0;
+    size_t size_ = 0;
+    bool has_zero_ = false;
+    Slot zero_slot_{};
+    bool huge_pages_;
+
+    inline size_t home(uint64_t key) const {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift_);
+    }
+
+    static size_t slots_for(size_t count) {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity * MAX_LOAD_NUM < count * MAX_LOAD_DEN) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    void allocate(size_t capacity) {
+        size_t bytes = capacity * sizeof(Slot);
+        if (huge_pages_) {
+            bytes = (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        }
+        void *mem = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        if (huge_pages_) {
+            mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        }
+#endif
+        if (mem == MAP_FAILED) {
+            mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mem == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+#ifdef MADV_HUGEPAGE
+            if (huge_pages_) {
+                madvise(mem, bytes, MADV_HUGEPAGE);
+            }
+#endif
+        }
+        // anonymous mappings are zero filled, i.e. every slot starts out empty
+        slots_ = static_cast<Slot *>(mem);
+        mapped_bytes_ = bytes;
+        capacity_ = capacity;
+        mask_ = capacity - 1;
+        shift_ = 64 - static_cast<unsigned>(__builtin_ctzll(capacity));
+    }
+
+    static void release(Slot *slots, size_t bytes) {
+        if (slots) {
+            munmap(slots, bytes);
+        }
+    }
+
+    void rehash(size_t new_capacity) {
+        Slot *old_slots = slots_;
+        size_t old_capacity = capacity_;
+        size_t old_bytes = mapped_bytes_;
+        allocate(new_capacity);
+
+        for (size_t i = 0; i < old_capacity; ++i) {
+            const Slot &slot = old_slots[i];
+            if (slot.first == EMPTY_KEY) {
+                continue;
+            }
+            size_t j = home(slot.first);
+            while (slots_[j].first != EMPTY_KEY) {
+                j = (j + 1) & mask_;
+            }
+            slots_[j] = slot;
+        }
+        release(old_slots, old_bytes);
+    }
+};
+
+#endif //DATABENTO_ORDERBOOK_ORDER_MAP_H
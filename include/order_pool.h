@@ -1,39 +1,64 @@
-
 #ifndef DATABENTO_ORDERBOOK_ORDER_POOL_H
 #define DATABENTO_ORDERBOOK_ORDER_POOL_H
+
 #include "order.h"
+#include <cstdint>
+#include <memory>
 #include <vector>
 
-
-
+// orders live in contiguous slabs of SLAB_SIZE and are addressed by a 32-bit handle (slab
+// index in the high bits, offset in the low bits). each slab holds the hot Order structs and
+// a parallel array of cold OrderInfo at the same offsets. free orders are chained through
+// Order::next_, so allocation and release are a handle swap and memory is only requested
+// from the heap when every slab is in use.
 class OrderPool {
 private:
-    std::vector<std::unique_ptr<Order>> pool_;
-    std::vector<Order*> available_orders_;
+    static constexpr uint32_t SLAB_BITS = 16;
+    static constexpr uint32_t SLAB_SIZE = 1u << SLAB_BITS;
+    static constexpr uint32_t SLAB_MASK = SLAB_SIZE - 1;
+
+    std::vector<std::unique_ptr<Order[]>> slabs_;
+    std::vector<std::unique_ptr<OrderInfo[]>> info_slabs_;
+    uint32_t free_list_;
+
+    void add_slab();
 
 public:
+    static constexpr uint32_t NULL_HANDLE = Order::NULL_ORDER;
+
     explicit OrderPool(size_t);
-    //~OrderPool();
-    inline Order* get_order() {
-        if (available_orders_.empty()) {
-            pool_.push_back(std::make_unique<Order>());
-            return pool_.back().get();
+
+    inline uint32_t acquire() {
+        if (free_list_ == NULL_HANDLE) {
+            add_slab();
         }
-        Order* order = available_orders_.back();
-        available_orders_.pop_back();
-        return order;
+        uint32_t handle = free_list_;
+        Order* order = at(handle);
+        free_list_ = order->next_;
+        order->next_ = NULL_HANDLE;
+        order->prev_ = NULL_HANDLE;
+        order->parent_ = NULL_HANDLE;
+        order->filled_ = false;
+        return handle;
     }
 
-    inline void return_order(Order* order) {
-        available_orders_.push_back(order);
+    inline void release(uint32_t handle) {
+        at(handle)->next_ = free_list_;
+        free_list_ = handle;
+    }
 
+    inline Order* at(uint32_t handle) const {
+        return &slabs_[handle >> SLAB_BITS][handle & SLAB_MASK];
     }
 
-    inline void reset() {
-        pool_.clear();
-        pool_.reserve(1000000);
+    inline OrderInfo& info(uint32_t handle) const {
+        return info_slabs_[handle >> SLAB_BITS][handle & SLAB_MASK];
     }
-};
 
+    size_t capacity() const { return slabs_.size() * SLAB_SIZE; }
+
+    // makes every order available again, slabs are kept
+    void reset();
+};
 
 #endif //DATABENTO_ORDERBOOK_ORDER_POOL_H
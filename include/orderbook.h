@@ -3,41 +3,38 @@
 
 #include <cstdint>
 #include <map>
-#include <unordered_map>
-#include <boost/functional/hash.hpp>
 #include <utility>
-#include <arm_neon.h>
 #include <iterator>
+#include <array>
 #include "order.h"
 #include "limit.h"
 #include "limit_pool.h"
+#include "book_side.h"
+#include "depth_aggregate.h"
+#include "depth_kernels.h"
+#include "bbo.h"
+#include "checkpoint.h"
+#include "session_clock.h"
 #include "order_pool.h"
+#include "order_map.h"
 #include "message.h"
 #include "database.h"
 
-template<bool Side>
-struct BookSide {
-};
-
-template<>
-struct BookSide<true> {
-    using MapType = std::map<int32_t, Limit *, std::greater<>>;
-    static constexpr bool is_bid = true;
+// number of best levels per side summed into bid_vol_ / ask_vol_
+#ifndef ORDERBOOK_DEPTH_LEVELS
+#define ORDERBOOK_DEPTH_LEVELS 100
+#endif
 
-};
-
-template<>
-struct BookSide<false> {
-    using MapType = std::map<int32_t, Limit *, std::less<>>;
-    static constexpr bool is_bid = false;
-};
+class Orderbook;
 
+// invoked synchronously at the end of every exchange event, the book is consistent then
+using EventCallback = void (*)(const Orderbook &book, void *context);
 
 class Orderbook {
 private:
     DatabaseManager &db_manager_;
     OrderPool order_pool_;
-    std::unordered_map<std::pair<int32_t, bool>, Limit *, boost::hash<std::pair<int32_t, bool>>> limit_lookup_;
+    LimitPool limit_pool_;
     uint64_t bid_count_;
     uint64_t ask_count_;
 
@@ -48,10 +45,60 @@ private:
     Limit *get_or_insert_limit(int32_t price);
 
     template<bool Side>
-    void update_vol(int32_t price, int32_t size, bool is_add);
+    uint32_t create_order(uint64_t id, int32_t price, uint32_t size, uint64_t unix_time);
+
+    template<bool Side>
+    void erase_limit(Limit *limit);
 
     template<bool Side>
-    void update_modify_vol(int32_t og_price, int32_t new_prive, int32_t og_size, int32_t new_size);
+    auto &get_depth() {
+        if constexpr (Side) {
+            return bid_top_;
+        } else {
+            return ask_top_;
+        }
+    }
+
+    template<bool Side>
+    void sync_depth();
+
+    // refreshes the cached top of book after a change at `price` on one side
+    template<bool Side>
+    void update_bbo(int32_t price);
+
+    // bumps bbo_version_ and calls the callback if bbo_ differs from what was last published
+    void publish_bbo();
+
+    // runs at the end of every exchange event (a message with F_LAST): the per-event
+    // aggregates, the Bbo publication and the event callback
+    void end_event();
+
+    // process_batch prefetch distances, in messages
+    static constexpr size_t PREFETCH_SLOT_AHEAD = 16;
+    static constexpr size_t PREFETCH_ORDER_AHEAD = 8;
+    static constexpr size_t PREFETCH_LIMIT_AHEAD = 3;
+
+    void prefetch_slot(const message &msg) const;
+
+    void prefetch_order(const message &msg);
+
+    void prefetch_limit(const message &msg);
+
+    Bbo bbo_;                // always current, also in the middle of an event
+    Bbo published_bbo_;      // as of the last event boundary
+    bool bbo_changed_ = false;
+    uint64_t bbo_version_ = 0;
+    uint64_t voi_bbo_version_ = 0;
+    BboCallback bbo_callback_ = nullptr;
+    void *bbo_context_ = nullptr;
+
+    bool in_event_ = false;
+    uint64_t event_count_ = 0;
+    EventCallback event_callback_ = nullptr;
+    void *event_context_ = nullptr;
+
+    std::array<uint32_t, ORDERBOOK_DEPTH_LEVELS> bid_levels_{};
+    std::array<uint32_t, ORDERBOOK_DEPTH_LEVELS> ask_levels_{};
 
     static constexpr size_t BUFFER_SIZE = 40000;
     size_t write_index_ = 0;
@@ -63,23 +110,40 @@ public:
     std::vector<int32_t> mid_prices_;
     std::vector<int32_t> mid_prices_curr_;
 
-    bool update_possible = false;
+    static constexpr size_t DEPTH_LEVELS = ORDERBOOK_DEPTH_LEVELS;
+
     BookSide<true>::MapType bids_;
     BookSide<false>::MapType offers_;
-    std::unordered_map<uint64_t, Order *> order_lookup_;
-    std::chrono::system_clock::time_point current_message_time_;
+    DepthAggregate<BookSide<true>, DEPTH_LEVELS> bid_top_;
+    DepthAggregate<BookSide<false>, DEPTH_LEVELS> ask_top_;
+    OrderMap<uint32_t> order_lookup_;
+    SessionClock clock_; // exchange time of the last applied message
     double vwap_, sum1_, sum2_;
     float skew_, bid_depth_, ask_depth_;
-    int32_t bid_vol_, ask_vol_;
+    int32_t bid_vol_, ask_vol_; // volume over the top DEPTH_LEVELS levels, kept current by bid_top_/ask_top_
     std::string last_reset_time_;
     double imbalance_;
 
-    explicit Orderbook(DatabaseManager &db_manager);
+    // price step of the csv exports and DbnPriceScale::hundredths(): 0.25 -> 25
+    static constexpr int32_t ES_TICK_SIZE = 25;
+
+    // tick_size is the instrument tick in book price units, 1 for DbnPriceScale::ticks()
+    explicit Orderbook(DatabaseManager &db_manager, size_t order_capacity = 1000000,
+                       int32_t tick_size = ES_TICK_SIZE);
 
     ~Orderbook();
 
     void reset();
 
+    // writes every resting order (queue order preserved) and the running trade stats to a
+    // binary file, see checkpoint.h. message_index is stored for the caller, typically the
+    // index of the next message to replay.
+    bool save_checkpoint(const std::string &path, uint64_t message_index) const;
+
+    // replaces the book with a checkpoint's contents. returns false and leaves the book
+    // untouched if `path` is not a valid checkpoint.
+    bool load_checkpoint(const std::string &path, uint64_t *message_index = nullptr);
+
     void calculate_skew();
 
     void add_mid_price() {
@@ -102,97 +166,98 @@ public:
 
     void calculate_imbalance();
 
+    // volumes of the best `levels` levels of one side into `out`, touch first, zero padded
+    template<bool Side>
+    void copy_level_volumes(uint32_t *out, size_t levels) const;
+
+    // (weighted bid depth - weighted ask depth) / (weighted bid depth + weighted ask depth)
+    // over the best `levels` (<= DEPTH_LEVELS) levels, weights[0] applies to the touch
+    double weighted_imbalance(const double *weights, size_t levels);
+
+    // out[k] = imbalance of the cumulative depth through level k, returns the number of levels written
+    size_t depth_imbalance(double *out, size_t levels);
+
     int32_t bid_delta_;
     int32_t ask_delta_;
-    int32_t prev_best_bid_;
-    int32_t prev_best_ask_;
-    int32_t prev_best_bid_volume_;
-    int32_t prev_best_ask_volume_;
+    int32_t prev_best_bid_ = 0;
+    int32_t prev_best_ask_ = 0;
+    int32_t prev_best_bid_volume_ = 0;
+    int32_t prev_best_ask_volume_ = 0;
     int32_t voi_;
 
-    inline void calculate_voi() {
-        int32_t bid_delta = get_best_bid_price() - prev_best_bid_;
-        int32_t ask_delta = get_best_ask_price() - prev_best_ask_;
-
-        int32_t bid_cv = 0;
-        int32_t ask_cv = 0;
-
-        if (bid_delta >= 0) {
-            if (bid_delta == 0) {
-                bid_cv = get_best_bid_volume() - prev_best_bid_volume_;
-            } else {
-                bid_cv = get_best_bid_volume();
-            }
+    // volume order imbalance since the previous sample, 0 without touching the book when the
+    // top of book has not changed in between
+    inline int32_t sample_voi() {
+        if (bbo_version_ == voi_bbo_version_) {
+            return 0;
         }
+        voi_bbo_version_ = bbo_version_;
 
-        if (ask_delta <= 0) {
-            if (ask_delta == 0) {
-                ask_cv = get_best_ask_volume() - prev_best_ask_volume_;
-            } else {
-                ask_cv = get_best_ask_volume();
-            }
-        }
-
-        voi_ = bid_cv - ask_cv;
-        voi_history_.push_back(voi_);
+        Bbo prev;
+        prev.bid_price_ = prev_best_bid_;
+        prev.ask_price_ = prev_best_ask_;
+        prev.bid_volume_ = static_cast<uint32_t>(prev_best_bid_volume_);
+        prev.ask_volume_ = static_cast<uint32_t>(prev_best_ask_volume_);
 
         prev_best_bid_ = get_best_bid_price();
         prev_best_ask_ = get_best_ask_price();
         prev_best_bid_volume_ = get_best_bid_volume();
         prev_best_ask_volume_ = get_best_ask_volume();
+        return order_imbalance(prev, bbo_);
+    }
+
+    inline void calculate_voi() {
+        voi_ = sample_voi();
+        voi_history_.push_back(voi_);
     }
 
     inline void calculate_voi_curr() {
-        int32_t bid_delta = get_best_bid_price() - prev_best_bid_;
-        int32_t ask_delta = get_best_ask_price() - prev_best_ask_;
-
-        int32_t bid_cv = 0;
-        int32_t ask_cv = 0;
-
-        if (bid_delta >= 0) {
-            if (bid_delta == 0) {
-                bid_cv = get_best_bid_volume() - prev_best_bid_volume_;
-            } else {
-                bid_cv = get_best_bid_volume();
-            }
-        }
+        voi_ = sample_voi();
+        voi_history_curr_.push_back(voi_);
+    }
 
-        if (ask_delta <= 0) {
-            if (ask_delta == 0) {
-                ask_cv = get_best_ask_volume() - prev_best_ask_volume_;
-            } else {
-                ask_cv = get_best_ask_volume();
-            }
-        }
+    const Bbo &get_bbo() const { return bbo_; }
 
-        voi_ = bid_cv - ask_cv;
-        voi_history_curr_.push_back(voi_);
+    // bumped at the end of every event that changed the cached top of book, compare against
+    // a stored value to see whether anything moved since the last look
+    uint64_t get_bbo_version() const { return bbo_version_; }
 
-        prev_best_bid_ = get_best_bid_price();
-        prev_best_ask_ = get_best_ask_price();
-        prev_best_bid_volume_ = get_best_bid_volume();
-        prev_best_ask_volume_ = get_best_ask_volume();
+    // called once per event that moved the top of book, not per message
+    void set_bbo_callback(BboCallback callback, void *context = nullptr) {
+        bbo_callback_ = callback;
+        bbo_context_ = context;
     }
 
-    inline int32_t get_best_bid_volume() {
-        return bids_.begin()->second->volume_;
+    void set_event_callback(EventCallback callback, void *context = nullptr) {
+        event_callback_ = callback;
+        event_context_ = context;
     }
 
-    inline int32_t get_best_ask_volume() {
-        return offers_.begin()->second->volume_;
+    // true between a message without F_LAST and the end of its event. derived values
+    // (imbalance_, the Bbo version) still describe the previous event boundary then
+    bool in_event() const { return in_event_; }
+
+    uint64_t get_event_count() const { return event_count_; }
+
+    inline int32_t get_best_bid_volume() const {
+        return static_cast<int32_t>(bbo_.bid_volume_);
     }
 
-    uint64_t get_bid_depth() const;
+    inline int32_t get_best_ask_volume() const {
+        return static_cast<int32_t>(bbo_.ask_volume_);
+    }
 
-    uint64_t get_ask_depth() const;
+    uint64_t get_bid_depth() const { return bbo_.bid_volume_; }
 
-    int32_t get_best_bid_price() const;
+    uint64_t get_ask_depth() const { return bbo_.ask_volume_; }
 
-    int32_t get_best_ask_price() const;
+    int32_t get_best_bid_price() const { return bbo_.bid_price_; }
 
+    int32_t get_best_ask_price() const { return bbo_.ask_price_; }
     uint64_t get_count() const;
 
-    std::string get_formatted_time_fast() const;
+    // formatted on demand, compare clock_ values instead in per message code
+    std::string get_formatted_time_fast() const { return clock_.format(); }
 
     template<bool Side>
     void add_limit_order(uint64_t id, int32_t price, uint32_t size, uint64_t unix_time);
@@ -204,24 +269,19 @@ public:
     void trade_order(uint64_t id, int32_t price, uint32_t size);
 
     template<bool Side>
-    void remove_order(uint64_t id, int32_t price, uint32_t size);
-
-    template<bool Side>
-    int32_t &get_volume();
+    void remove_order(uint64_t id);
 
     inline void process_msg(const message &msg) {
         ++ct_;
-        auto nanoseconds = std::chrono::nanoseconds(msg.time_);
-        auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(nanoseconds);
-        current_message_time_ = std::chrono::system_clock::time_point(microseconds);
+        clock_.advance(msg.time_);
         switch (msg.action_) {
             case 'A':
                 msg.side_ ? add_limit_order<true>(msg.id_, msg.price_, msg.size_, msg.time_)
                           : add_limit_order<false>(msg.id_, msg.price_, msg.size_, msg.time_);
                 break;
             case 'C':
-                msg.side_ ? remove_order<true>(msg.id_, msg.price_, msg.size_)
-                          : remove_order<false>(msg.id_, msg.price_, msg.size_);
+                msg.side_ ? remove_order<true>(msg.id_)
+                          : remove_order<false>(msg.id_);
                 break;
             case 'M':
                 msg.side_ ? modify_order<true>(msg.id_, msg.price_, msg.size_, msg.time_)
@@ -232,44 +292,22 @@ public:
                           : trade_order<false>(msg.id_, msg.price_, msg.size_);
                 break;
         }
+        if (msg.flags_ & message::F_LAST) {
+            end_event();
+        } else {
+            in_event_ = true;
+        }
 
     }
 
-    inline int32_t get_mid_price() {
-        return (get_best_bid_price() + get_best_ask_price()) / 2;
-    }
-
-    inline void calculate_vols() {
-        uint32x4_t bid_vol_vec = vdupq_n_u32(0);
-        uint32x4_t ask_vol_vec = vdupq_n_u32(0);
-
-        auto bid_it = bids_.begin();
-        auto bid_end = bids_.end();
-        auto ask_it = offers_.begin();
-        auto ask_end = offers_.end();
-
-        for (int i = 0; i < 100 && (bid_it != bid_end || ask_it != ask_end); i += 4) {
-            uint32_t bid_chunk[4] = {0, 0, 0, 0};
-            uint32_t ask_chunk[4] = {0, 0, 0, 0};
-
-            for (int j = 0; j < 4; ++j) {
-                if (bid_it != bid_end) {
-                    bid_chunk[j] = bid_it->second->volume_;
-                    ++bid_it;
-                }
-                if (ask_it != ask_end) {
-                    ask_chunk[j] = ask_it->second->volume_;
-                    ++ask_it;
-                }
-            }
-
-            bid_vol_vec = vaddq_u32(bid_vol_vec, vld1q_u32(bid_chunk));
-            ask_vol_vec = vaddq_u32(ask_vol_vec, vld1q_u32(ask_chunk));
-        }
+    // same result as calling process_msg on each message in turn. while one message is
+    // applied, the order id hash slot, the Order and then its Limit and queue neighbours of
+    // messages further ahead are prefetched, so their cache misses overlap instead of
+    // serialising one message after another
+    void process_batch(const message *msgs, size_t count);
 
-        bid_vol_ = vaddvq_u32(bid_vol_vec);
-        ask_vol_ = vaddvq_u32(ask_vol_vec);
-        update_possible = true;
+    inline int32_t get_mid_price() const {
+        return (bbo_.bid_price_ + bbo_.ask_price_) / 2;
     }
 
     inline void calculate_vwap(int32_t price, int32_t size) {
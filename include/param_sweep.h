@@ -0,0 +1,79 @@
+#ifndef DATABENTO_ORDERBOOK_PARAM_SWEEP_H
+#define DATABENTO_ORDERBOOK_PARAM_SWEEP_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "database.h"
+#include "message.h"
+#include "linear_model_strat.h"
+#include "imbalance_strat.h"
+
+enum class SweepStrategy : uint8_t {
+    LinearModel,
+    Imbalance
+};
+
+// one grid point, only the params of `strategy_` are used
+struct SweepPoint {
+    SweepStrategy strategy_;
+    LinearModelParams linear_;
+    ImbalanceParams imbalance_;
+};
+
+struct SweepResult {
+    SweepPoint point_;
+    int32_t pnl_;
+    int position_;
+    int trades_;
+    size_t messages_;      // replayed after the warm start
+    double seconds_;       // wall time of this point, fit and replay
+    uint32_t worker_;      // thread that ran it
+};
+
+// cartesian products of the given values, the other params keep their defaults
+std::vector<SweepPoint> linear_model_grid(const std::vector<int> &max_lags, const std::vector<int> &forecast_windows,
+                                          const std::vector<double> &thresholds);
+
+std::vector<SweepPoint> imbalance_grid(const std::vector<size_t> &depths, const std::vector<double> &thresholds);
+
+// runs every point of a grid as its own backtest on a pool of threads. the parsed streams are
+// shared read-only; each point gets its own book, strategy and BacktestEngine. the training
+// day's per-second voi/mid series and the session-open checkpoint are built once, up front, so
+// workers only fit their model and replay the session. points are dealt round-robin to
+// per-thread deques and idle threads steal from the others, so uneven points still keep every
+// core busy until the grid is done.
+class ParameterSweep {
+public:
+    // both streams must outlive the sweep
+    ParameterSweep(DatabaseManager &db_manager, MessageSpan messages, MessageSpan train_messages);
+
+    // exchange time "yyyy-mm-dd hh:mm:ss.zzz", see SessionClock::parse
+    void set_session(const std::string &start_time, const std::string &end_time);
+
+    void set_train_session(const std::string &start_time, const std::string &end_time);
+
+    // one result per point, in grid order
+    std::vector<SweepResult> run(const std::vector<SweepPoint> &grid, size_t threads);
+
+    static void print_table(const std::vector<SweepResult> &results, FILE *out = stdout);
+
+private:
+    DatabaseManager &db_manager_;
+    MessageSpan messages_;
+    MessageSpan train_messages_;
+    std::string start_time_ = "2024-06-04 08:30:00.000";
+    std::string end_time_ = "2024-06-04 15:00:00.000";
+    std::string train_start_time_ = "2024-06-03 08:30:00.000";
+    std::string train_end_time_ = "2024-06-03 15:00:00.000";
+
+    // training day samples, filled by run() before any worker starts
+    std::vector<int32_t> voi_history_;
+    std::vector<int32_t> mid_prices_;
+
+    SweepResult run_point(const SweepPoint &point, uint32_t worker) const;
+};
+
+#endif //DATABENTO_ORDERBOOK_PARAM_SWEEP_H
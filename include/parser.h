@@ -8,6 +8,7 @@
 #include <memory>
 #include <iostream>
 #include "message.h"
+#include "csv_scan.h"
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -15,17 +16,38 @@
 
 class Parser {
 public:
-    explicit Parser(const std::string &file_path);
+    // the csv has no instrument column, every message is tagged with `instrument_id`
+    explicit Parser(const std::string &file_path, uint32_t instrument_id = 0);
     ~Parser();
-    void parse();
+    // threads > 1 splits the file at line boundaries and parses the pieces concurrently, each
+    // straight into its own slice of message_stream_. the result is the same either way
+    void parse(size_t threads = 1);
+    // defaults to csv_scan_kernels(), the bench compares backends
+    void set_scan_kernels(const CsvScanKernels &kernels) { kernels_ = &kernels; }
     std::vector<message> message_stream_;
 
+    // lines skipped at the top of every file
+    static constexpr size_t HEADER_LINES = 2;
+
+    // number of '\n' in [begin, end), an upper bound on the messages those lines hold
+    static size_t count_lines(const char* begin, const char* end);
+
+    // parses the whole lines in [begin, end) into `out`, which needs room for count_lines() of
+    // them. end is one past a '\n' and CSV_PADDING bytes after it must be readable. returns the
+    // number written, lines too short to be a message are added to `malformed`
+    size_t parse_range(const char* begin, const char* end, message* out, size_t& malformed) const;
+
 private:
+    // commas recorded per line, the columns after the sequence are never read
+    static constexpr size_t MAX_COMMAS = 16;
+
     std::string file_path_;
+    uint32_t instrument_id_;
     char* mapped_file_;
     size_t file_size_;
-    void parse_mapped_data();
-    void parse_line(const char* start, const char* end);
+    const CsvScanKernels* kernels_;
+    void parse_mapped_data(size_t threads);
+    bool parse_line(const char* start, const char* const* commas, size_t count, const char* end, message& out) const;
 };
 
 #endif  //DATABENTO_ORDERBOOK_PARSER_H
@@ -0,0 +1,395 @@
+#ifndef DATABENTO_ORDERBOOK_PRICE_LADDER_H
+#define DATABENTO_ORDERBOOK_PRICE_LADDER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include "limit.h"
+
+// one side of the book stored as a flat, tick-indexed array of Limit pointers.
+// slot i holds the level at base_ + i * tick_size_. the window is centered on the
+// touch and recentered when the best price leaves it (or drifts close to the far edge).
+// levels worse than the window (stale orders far from the touch) spill into an
+// overflow map, so the best price is always inside the window when the side is non-empty.
+// iteration order matches std::map with the side's comparator: best price first.
+// tick_size is the instrument tick in book price units (25 for ES in hundredths). a price off
+// that grid shrinks the tick to the common divisor and rebuilds the window, so a book built
+// with the wrong tick stays correct, only with a narrower window.
+template<bool Side, size_t Levels = 4096>
+class PriceLadder {
+public:
+    using Compare = std::conditional_t<Side, std::greater<>, std::less<>>;
+    using OverflowMap = std::map<int32_t, Limit *, Compare>;
+    using value_type = std::pair<int32_t, Limit *>;
+
+    static_assert(Levels >= 16, "ladder window too small");
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = PriceLadder::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type *;
+        using reference = const value_type &;
+
+        const_iterator() = default;
+
+        reference operator*() const { return curr_; }
+
+        pointer operator->() const { return &curr_; }
+
+        const_iterator &operator++() {
+            if (idx_ != OVERFLOW_IDX) {
+                idx_ = ladder_->next_worse(idx_);
+                if (idx_ == NPOS) {
+                    idx_ = OVERFLOW_IDX;
+                    overflow_it_ = ladder_->overflow_.begin();
+                }
+            } else {
+                ++overflow_it_;
+            }
+            load();
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        bool operator==(const const_iterator &other) const {
+            return idx_ == other.idx_ && (idx_ != OVERFLOW_IDX || overflow_it_ == other.overflow_it_);
+        }
+
+        bool operator!=(const const_iterator &other) const { return !(*this == other); }
+
+    private:
+        friend class PriceLadder;
+
+        const_iterator(const PriceLadder *ladder, ptrdiff_t idx, typename OverflowMap::const_iterator overflow_it)
+                : ladder_(ladder), idx_(idx), overflow_it_(overflow_it) {
+            load();
+        }
+
+        inline void load() {
+            if (idx_ != OVERFLOW_IDX) {
+                curr_ = {ladder_->price_at(idx_), ladder_->slots_[idx_]};
+            } else if (overflow_it_ != ladder_->overflow_.end()) {
+                curr_ = {overflow_it_->first, overflow_it_->second};
+            }
+        }
+
+        const PriceLadder *ladder_ = nullptr;
+        ptrdiff_t idx_ = OVERFLOW_IDX;
+        typename OverflowMap::const_iterator overflow_it_;
+        value_type curr_{0, nullptr};
+    };
+
+    using iterator = const_iterator;
+
+    explicit PriceLadder(int32_t tick_size = 1)
+            : slots_(Levels, nullptr), scratch_(Levels, nullptr), tick_size_(tick_size) {}
+
+    PriceLadder(const PriceLadder &) = delete;
+    PriceLadder &operator=(const PriceLadder &) = delete;
+
+    const_iterator begin() const {
+        if (window_count_ == 0) {
+            return end();
+        }
+        return const_iterator(this, best_, overflow_.end());
+    }
+
+    const_iterator end() const { return const_iterator(this, OVERFLOW_IDX, overflow_.end()); }
+
+    bool empty() const { return window_count_ == 0; }
+
+    size_t size() const { return window_count_ + overflow_.size(); }
+
+    int32_t tick_size() const { return tick_size_; }
+
+    const_iterator find(int32_t price) const {
+        ptrdiff_t idx = index_of(price);
+        if (idx == NPOS) {
+            return const_iterator(this, OVERFLOW_IDX, overflow_.find(price));
+        }
+        if (slots_[idx] == nullptr) {
+            return end();
+        }
+        return const_iterator(this, idx, overflow_.end());
+    }
+
+    bool emplace(int32_t price, Limit *limit) {
+        if (window_count_ == 0) {
+            recenter(price);
+        } else if (!on_grid(price)) {
+            regrid(static_cast<int32_t>(std::gcd(static_cast<int64_t>(tick_size_), price - base_)));
+        }
+
+        ptrdiff_t idx = index_of(price);
+        if (idx == NPOS) {
+            if (!Compare{}(price, price_at(best_))) {
+                return overflow_.emplace(price, limit).second;
+            }
+            recenter(price);
+            idx = index_of(price);
+        }
+
+        if (slots_[idx] != nullptr) {
+            return false;
+        }
+        slots_[idx] = limit;
+        ++window_count_;
+        if (best_ == NPOS || is_better(idx, best_)) {
+            best_ = idx;
+        }
+        return true;
+    }
+
+    size_t erase(int32_t price) {
+        ptrdiff_t idx = index_of(price);
+        if (idx == NPOS) {
+            return overflow_.erase(price);
+        }
+        if (slots_[idx] == nullptr) {
+            return 0;
+        }
+
+        slots_[idx] = nullptr;
+        --window_count_;
+        if (idx == best_) {
+            best_ = next_worse(idx);
+            if (best_ == NPOS) {
+                if (!overflow_.empty()) {
+                    recenter(overflow_.begin()->first);
+                }
+            } else if (distance_to_far_edge(best_) < static_cast<ptrdiff_t>(Levels / 4)) {
+                recenter(price_at(best_));
+            }
+        }
+        return 1;
+    }
+
+    void clear() {
+        std::fill(slots_.begin(), slots_.end(), nullptr);
+        overflow_.clear();
+        window_count_ = 0;
+        best_ = NPOS;
+    }
+
+    // closest level strictly worse than `price`, nullptr if none.
+    // overflow levels are all worse than the window, so the window is searched first.
+    Limit *level_worse_than(int32_t price) const {
+        if (window_count_ == 0) {
+            return nullptr;
+        }
+        if (!on_grid(price)) {
+            // no level sits between price and the next grid price on its worse side
+            price = snap(price, !Side);
+            if (Limit *limit = level_at(price)) {
+                return limit;
+            }
+        }
+        ptrdiff_t idx = index_of(price);
+        if (idx == NPOS) {
+            if (Compare{}(price, price_at(best_))) {
+                return slots_[best_];
+            }
+            auto it = overflow_.upper_bound(price);
+            return it != overflow_.end() ? it->second : nullptr;
+        }
+        ptrdiff_t worse = next_worse(idx);
+        if (worse != NPOS) {
+            return slots_[worse];
+        }
+        return overflow_.empty() ? nullptr : overflow_.begin()->second;
+    }
+
+    // closest level strictly better than `price`, nullptr if none
+    Limit *level_better_than(int32_t price) const {
+        if (window_count_ == 0) {
+            return nullptr;
+        }
+        if (!on_grid(price)) {
+            price = snap(price, Side);
+            if (Limit *limit = level_at(price)) {
+                return limit;
+            }
+        }
+        ptrdiff_t idx = index_of(price);
+        if (idx == NPOS) {
+            if (Compare{}(price, price_at(best_))) {
+                return nullptr;
+            }
+            auto it = overflow_.lower_bound(price);
+            if (it != overflow_.begin()) {
+                return std::prev(it)->second;
+            }
+            // worse than the whole window, start from just past its far edge
+            idx = Side ? NPOS : static_cast<ptrdiff_t>(Levels);
+        }
+        ptrdiff_t better = next_better(idx);
+        return better != NPOS ? slots_[better] : nullptr;
+    }
+
+private:
+    static constexpr ptrdiff_t NPOS = -1;
+    static constexpr ptrdiff_t OVERFLOW_IDX = static_cast<ptrdiff_t>(Levels);
+
+    std::vector<Limit *> slots_;
+    std::vector<Limit *> scratch_;
+    OverflowMap overflow_;
+    int64_t base_ = 0;
+    int32_t tick_size_;
+    size_t window_count_ = 0;
+    ptrdiff_t best_ = NPOS;
+
+    inline int32_t price_at(ptrdiff_t idx) const {
+        return static_cast<int32_t>(base_ + static_cast<int64_t>(idx) * tick_size_);
+    }
+
+    // NPOS outside the window and off the grid, levels off the grid are never stored
+    inline ptrdiff_t index_of(int32_t price) const {
+        int64_t offset = static_cast<int64_t>(price) - base_;
+        if (offset < 0) {
+            return NPOS;
+        }
+        int64_t idx = offset / tick_size_;
+        return idx * tick_size_ == offset && idx < static_cast<int64_t>(Levels) ? static_cast<ptrdiff_t>(idx) : NPOS;
+    }
+
+    inline bool on_grid(int32_t price) const { return (static_cast<int64_t>(price) - base_) % tick_size_ == 0; }
+
+    // the grid price just above (up) or below an off-grid price
+    int32_t snap(int32_t price, bool up) const {
+        int64_t offset = static_cast<int64_t>(price) - base_;
+        int64_t steps = offset / tick_size_ - (offset < 0) + up;
+        return static_cast<int32_t>(std::clamp<int64_t>(base_ + steps * tick_size_, INT32_MIN, INT32_MAX));
+    }
+
+    Limit *level_at(int32_t price) const {
+        const_iterator it = find(price);
+        return it != end() ? it->second : nullptr;
+    }
+
+    // the window is rebuilt on a finer tick around the best level, everything else waits in the
+    // overflow map until it fits
+    void regrid(int32_t tick_size) {
+        for (ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(Levels); ++i) {
+            if (slots_[i] != nullptr) {
+                overflow_.emplace(price_at(i), slots_[i]);
+                slots_[i] = nullptr;
+            }
+        }
+        tick_size_ = tick_size;
+        window_count_ = 0;
+        best_ = NPOS;
+        recenter(overflow_.begin()->first);
+    }
+
+    // bids improve towards higher slots, offers towards lower slots
+    static inline bool is_better(ptrdiff_t a, ptrdiff_t b) {
+        if constexpr (Side) {
+            return a > b;
+        } else {
+            return a < b;
+        }
+    }
+
+    inline ptrdiff_t distance_to_far_edge(ptrdiff_t idx) const {
+        if constexpr (Side) {
+            return idx;
+        } else {
+            return static_cast<ptrdiff_t>(Levels) - 1 - idx;
+        }
+    }
+
+    inline ptrdiff_t next_worse(ptrdiff_t idx) const {
+        if constexpr (Side) {
+            for (ptrdiff_t i = idx - 1; i >= 0; --i) {
+                if (slots_[i] != nullptr) {
+                    return i;
+                }
+            }
+        } else {
+            for (ptrdiff_t i = idx + 1; i < static_cast<ptrdiff_t>(Levels); ++i) {
+                if (slots_[i] != nullptr) {
+                    return i;
+                }
+            }
+        }
+        return NPOS;
+    }
+
+    inline ptrdiff_t next_better(ptrdiff_t idx) const {
+        if constexpr (Side) {
+            for (ptrdiff_t i = idx + 1; i < static_cast<ptrdiff_t>(Levels); ++i) {
+                if (slots_[i] != nullptr) {
+                    return i;
+                }
+            }
+        } else {
+            for (ptrdiff_t i = idx - 1; i >= 0; --i) {
+                if (slots_[i] != nullptr) {
+                    return i;
+                }
+            }
+        }
+        return NPOS;
+    }
+
+    // moves the window so that `center` sits in the middle slot. levels that fall off the
+    // far edge go to the overflow map, overflow levels that now fit are pulled back in.
+    void recenter(int32_t center) {
+        int64_t new_base = static_cast<int64_t>(center) - static_cast<int64_t>(Levels / 2) * tick_size_;
+
+        for (ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(Levels); ++i) {
+            Limit *limit = slots_[i];
+            if (limit == nullptr) {
+                continue;
+            }
+            slots_[i] = nullptr;
+            int32_t price = price_at(i);
+            int64_t offset = static_cast<int64_t>(price) - new_base;
+            if (offset >= 0 && offset / tick_size_ < static_cast<int64_t>(Levels)) {
+                scratch_[offset / tick_size_] = limit;
+            } else {
+                overflow_.emplace(price, limit);
+            }
+        }
+
+        slots_.swap(scratch_);
+        base_ = new_base;
+
+        while (!overflow_.empty()) {
+            auto it = overflow_.begin();
+            ptrdiff_t idx = index_of(it->first);
+            if (idx == NPOS) {
+                break;
+            }
+            slots_[idx] = it->second;
+            overflow_.erase(it);
+        }
+
+        window_count_ = 0;
+        best_ = NPOS;
+        for (ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(Levels); ++i) {
+            if (slots_[i] != nullptr) {
+                ++window_count_;
+                if (best_ == NPOS || is_better(i, best_)) {
+                    best_ = i;
+                }
+            }
+        }
+    }
+};
+
+#endif //DATABENTO_ORDERBOOK_PRICE_LADDER_H
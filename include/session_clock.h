@@ -0,0 +1,143 @@
+#ifndef DATABENTO_ORDERBOOK_SESSION_CLOCK_H
+#define DATABENTO_ORDERBOOK_SESSION_CLOCK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// utc offsets of one iana zone, read once from its tzif file under $TZDIR or /usr/share/zoneinfo:
+// the transition table, then the posix rule at the end of the file (CST6CDT,M3.2.0,M11.1.0 for
+// chicago) for times past it. a posix rule is also accepted in place of a name. never looks at
+// TZ or the process zone, so a clock reads the same on a utc server as on a desk in new york.
+class ExchangeZone {
+public:
+    // CME, where ES trades. its regular session is 08:30-15:00
+    static constexpr const char* CME = "America/Chicago";
+
+    // chicago's rule since 2007, for machines without tzdata
+    static constexpr const char* CME_RULE = "CST6CDT,M3.2.0,M11.1.0";
+
+    static const ExchangeZone& cme();
+
+    // a zone that can't be loaded is reported and replaced by `fallback_rule`, or utc without one
+    explicit ExchangeZone(const std::string& name, const std::string& fallback_rule = "");
+
+    const std::string& name() const { return name_; }
+
+    bool valid() const { return valid_; }
+
+    // local - utc in seconds at `utc_seconds`
+    int32_t utc_offset(int64_t utc_seconds) const;
+
+    int64_t to_local(int64_t utc_seconds) const { return utc_seconds + utc_offset(utc_seconds); }
+
+    // like mktime: a wall time skipped by a dst change maps an hour on, a repeated one to its
+    // first occurrence
+    int64_t to_utc(int64_t local_seconds) const;
+
+private:
+    // Mm.w.d/time: day d (0 = sunday) of week w (5 = last) of month m, at local time
+    struct Change {
+        int month_ = 0;
+        int week_ = 0;
+        int weekday_ = 0;
+        int32_t time_ = 7200;
+    };
+
+    struct Rule {
+        int32_t std_offset_ = 0;
+        int32_t dst_offset_ = 0;
+        bool has_dst_ = false;
+        Change start_;
+        Change end_;
+    };
+
+    std::string name_;
+    bool valid_ = false;
+    int32_t initial_offset_ = 0;        // before the first transition
+    std::vector<int64_t> transitions_;   // utc seconds, ascending
+    std::vector<int32_t> offsets_;       // in effect from the matching transition on
+    Rule rule_;
+
+    bool load_tzif(const std::string& path);
+    bool parse_rule(const std::string& rule);
+    int32_t rule_offset(int64_t utc_seconds) const;
+};
+
+// exchange time of the last applied message as raw ns since epoch. the exchange midnight of the
+// current day is resolved once per day, so per message work is a store and a compare and
+// seconds_since_midnight() is a subtraction and a divide. session open/close are absolute ns
+// set once per run, and strings are only built when format() is called.
+// days, midnights and time strings are in the clock's ExchangeZone (CME's America/Chicago
+// unless set_zone() says otherwise), not the process timezone.
+class SessionClock {
+public:
+    static constexpr uint64_t NS_PER_SECOND = 1000000000ULL;
+    static constexpr uint64_t NS_PER_MILLI = 1000000ULL;
+
+    inline void advance(uint64_t ns) {
+        now_ = ns;
+        if (ns >= next_midnight_ || ns < midnight_) {
+            roll(ns);
+        }
+    }
+
+    // forgets the time, keeps the session
+    void reset() {
+        now_ = 0;
+        midnight_ = 0;
+        next_midnight_ = 0;
+    }
+
+    uint64_t now() const { return now_; }
+
+    uint64_t seconds() const { return now_ / NS_PER_SECOND; }
+
+    uint64_t millis() const { return now_ / NS_PER_MILLI; }
+
+    uint32_t seconds_since_midnight() const {
+        return static_cast<uint32_t>((now_ - midnight_) / NS_PER_SECOND);
+    }
+
+    void set_session(uint64_t open_ns, uint64_t close_ns) {
+        session_open_ = open_ns;
+        session_close_ = close_ns;
+    }
+
+    uint64_t session_open() const { return session_open_; }
+
+    uint64_t session_close() const { return session_close_; }
+
+    bool after_open() const { return now_ >= session_open_; }
+
+    bool after_close() const { return now_ >= session_close_; }
+
+    bool in_session() const { return after_open() && !after_close(); }
+
+    // the zone must outlive the clock
+    void set_zone(const ExchangeZone &zone) {
+        zone_ = &zone;
+        roll(now_);
+    }
+
+    const ExchangeZone &zone() const { return *zone_; }
+
+    // "yyyy-mm-dd hh:mm:ss.zzz" in exchange time
+    std::string format() const;
+
+    // inverse of format(), ms may be omitted. returns 0 if `exchange_time` does not parse
+    static uint64_t parse(const std::string &exchange_time, const ExchangeZone &zone = ExchangeZone::cme());
+
+private:
+    uint64_t now_ = 0;
+    uint64_t midnight_ = 0;
+    uint64_t next_midnight_ = 0;
+    uint64_t session_open_ = 0;
+    uint64_t session_close_ = UINT64_MAX;
+    const ExchangeZone *zone_ = &ExchangeZone::cme();
+
+    // recomputes midnight_/next_midnight_ around ns, handles 23 and 25 hour days
+    void roll(uint64_t ns);
+};
+
+#endif //DATABENTO_ORDERBOOK_SESSION_CLOCK_H
@@ -0,0 +1,70 @@
+#ifndef DATABENTO_ORDERBOOK_SNAPSHOT_INDEX_H
+#define DATABENTO_ORDERBOOK_SNAPSHOT_INDEX_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "orderbook.h"
+#include "message.h"
+
+struct SnapshotIndexHeader {
+    char magic_[8];
+    uint32_t version_;
+    uint32_t interval_seconds_;
+    uint64_t message_count_;   // size of the indexed stream
+    uint64_t last_time_;       // time_ of its last message
+    uint64_t first_second_;    // exchange time (ns) of the first offset entry, whole second
+    uint64_t second_count_;
+    uint64_t snapshot_count_;
+};
+
+// a checkpoint of the book before messages[message_index_] is applied, always taken
+// between two exchange events
+struct SnapshotEntry {
+    uint64_t time_;            // time_ of messages[message_index_]
+    uint64_t message_index_;
+};
+
+// random access into one day of messages. build() replays the stream once and writes a
+// checkpoint (see checkpoint.h) every `interval_seconds` of exchange time into `dir`, plus
+// index.bin holding the snapshot list and, for every second of the day, the offset of the
+// first message at or after it.
+// book_at(ts) then restores the closest snapshot at or before ts and replays only the tail.
+class SnapshotIndex {
+public:
+    static constexpr char MAGIC[8] = {'O', 'B', 'S', 'N', 'P', 'I', 'D', 'X'};
+    static constexpr uint32_t VERSION = 1;
+
+    // `book` is used as scratch and left at the end of the stream
+    static bool build(Orderbook &book, const std::vector<message> &messages, const std::string &dir,
+                      uint32_t interval_seconds = 60);
+
+    // reads dir/index.bin, valid() is false if it is missing or malformed
+    explicit SnapshotIndex(const std::string &dir);
+
+    bool valid() const { return valid_; }
+
+    // true if `messages` looks like the stream the index was built from
+    bool matches(const std::vector<message> &messages) const;
+
+    // number of messages with time_ <= ts, i.e. the index of the first one after ts
+    size_t message_offset(const std::vector<message> &messages, uint64_t ts) const;
+
+    // puts `book` in the state after every message with time_ <= ts and returns how many
+    // messages that is. falls back to a replay from the start if no snapshot can be loaded
+    size_t book_at(Orderbook &book, const std::vector<message> &messages, uint64_t ts) const;
+
+    const std::vector<SnapshotEntry> &snapshots() const { return snapshots_; }
+
+    static std::string snapshot_path(const std::string &dir, uint64_t message_index);
+
+private:
+    std::string dir_;
+    bool valid_ = false;
+    SnapshotIndexHeader header_{};
+    std::vector<uint64_t> second_offsets_;
+    std::vector<SnapshotEntry> snapshots_;
+};
+
+#endif //DATABENTO_ORDERBOOK_SNAPSHOT_INDEX_H
@@ -1,6 +1,8 @@
 #pragma once
 #include <iostream>
 #include <memory>
+#include <queue>
+#include <tuple>
 #include "orderbook.h"
 #include "async_logger.h"
 
@@ -27,7 +29,6 @@ protected:
 
     //virtual void update_imbalance_stats(double imbalance) = 0;
     //virtual int calculate_trade_size(double imbalance) = 0;
-    //virtual void execute_trade(bool is_buy, int32_t price, int size) = 0;
     virtual void update_theo_values() = 0;
     virtual void calculate_pnl() = 0;
     virtual void log_stats(const Orderbook& book) = 0;
@@ -35,17 +36,25 @@ protected:
 
 
 public:
+    // an empty log_file_name runs the strategy quietly, without the async logger or console
+    // output, so a parameter sweep can run many of them side by side
     Strategy(DatabaseManager& db_manager, const std::string& log_file_name, Orderbook* book)
             : position_(0), buy_qty_(0), sell_qty_(0),
               real_total_buy_px_(0), real_total_sell_px_(0),
               theo_total_buy_px_(0), theo_total_sell_px_(0),
               fees_(0), pnl_(0), prev_pnl_(0), db_manager_(db_manager), book_(book) {
-        logger_ = std::make_unique<AsyncLogger>(log_file_name, db_manager);
+        if (!log_file_name.empty()) {
+            logger_ = std::make_unique<AsyncLogger>(log_file_name, db_manager);
+        }
     }
 
     std::queue<std::tuple<bool, int32_t>> trade_queue_;
 
+    // the engine replaces its book on reset, strategies follow it here
+    void set_book(Orderbook* book) { book_ = book; }
+
     virtual void reset() {
+        trade_queue_ = {};
         position_ = 0;
         buy_qty_ = 0;
         sell_qty_ = 0;
@@ -66,6 +75,9 @@ public:
 
     virtual void on_book_update() = 0;
 
+    virtual void execute_trade(bool is_buy, int32_t price, int size) = 0;
+
     int32_t get_pnl() const { return pnl_; }
     int get_position() const { return position_; }
+    int get_trade_count() const { return buy_qty_ + sell_qty_; }
 };
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef DATABENTO_ORDERBOOK_TIMER_WHEEL_H
+#define DATABENTO_ORDERBOOK_TIMER_WHEEL_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// `now_ns` is the exchange time passed to the advance() that fired the timer
+using TimerCallback = void (*)(uint64_t now_ns, void *context);
+
+// hierarchical timer wheel on exchange time. advance() is fed message timestamps and fires
+// every timer that came due, in (deadline, schedule order) order, so replays are deterministic.
+// LEVELS wheels of 64 slots, level k slots span 64^k ticks. a timer sits at the level of the
+// highest 6-bit digit in which its deadline differs from the wheel's position and drops a level
+// each time its slot comes up, so schedule/cancel are O(1) and advance() is a single compare
+// while nothing is due. an occupancy bitmask per level lets advance() jump over idle time.
+class TimerWheel {
+public:
+    using TimerId = uint64_t;
+    static constexpr TimerId NULL_TIMER = 0;
+
+    // tick_ns is the resolution: timers fire on the first advance() at or after their
+    // deadline rounded up to a whole tick
+    explicit TimerWheel(uint64_t tick_ns = 1000, uint64_t start_ns = 0);
+
+    // drops every timer and restarts the wheel at start_ns
+    void reset(uint64_t start_ns);
+
+    TimerId schedule_at(uint64_t deadline_ns, TimerCallback callback, void *context = nullptr);
+
+    // fires at first_ns, first_ns + period_ns, ... periods that pass between two advance()
+    // calls are skipped, a periodic timer fires at most once per advance(). it is retired once
+    // its next deadline would not fit in 64 bits
+    TimerId schedule_every(uint64_t period_ns, uint64_t first_ns, TimerCallback callback,
+                           void *context = nullptr);
+
+    // false if the timer already fired (one-shot) or was cancelled
+    bool cancel(TimerId id);
+
+    // fires everything due at now_ns. callbacks may schedule and cancel, a timer they
+    // schedule at or before now_ns fires within the same call
+    void advance(uint64_t now_ns);
+
+    size_t size() const { return active_; }
+
+    bool empty() const { return active_ == 0; }
+
+private:
+    static constexpr uint32_t SLOT_BITS = 6;
+    static constexpr uint32_t SLOTS = 1u << SLOT_BITS;
+    static constexpr uint32_t LEVELS = 10; // 60 bits of ticks, deadlines past that are parked at the top
+    static constexpr uint32_t NULL_INDEX = UINT32_MAX;
+
+    struct Timer {
+        uint64_t deadline_;    // ns
+        uint64_t period_;      // ns, 0 for one-shot
+        uint64_t sequence_;    // schedule order, breaks deadline ties
+        TimerCallback callback_;
+        void *context_;
+        uint32_t next_;        // slot list, or free list
+        uint32_t generation_;
+        bool active_;
+    };
+
+    uint64_t tick_ns_;
+    uint64_t elapsed_;         // wheel position in ticks, nothing due at or before it is left
+    uint64_t next_due_;        // lower bound of the first tick of every occupied slot, advance() returns below it
+    uint64_t sequence_ = 0;
+    size_t active_ = 0;
+
+    std::vector<Timer> timers_;
+    uint32_t free_list_ = NULL_INDEX;
+    std::array<std::array<uint32_t, SLOTS>, LEVELS> slots_;
+    std::array<uint64_t, LEVELS> occupied_;
+    std::vector<uint32_t> firing_;
+
+    uint64_t to_tick(uint64_t ns) const { return ns / tick_ns_ + (ns % tick_ns_ != 0); }
+
+    uint32_t acquire();
+
+    void release(uint32_t index);
+
+    void insert(uint32_t index);
+
+    // earliest slot holding timers: sets start (its first tick), level and slot. false if
+    // every slot is empty, the outputs are then left alone
+    bool next_expiration(uint64_t &start, uint32_t &level, uint32_t &slot) const;
+
+    void refresh_next_due();
+};
+
+#endif //DATABENTO_ORDERBOOK_TIMER_WHEEL_H
@@ -0,0 +1,142 @@
+// headless backtest: fits the model on the training day and replays the session day at full
+// speed with no gui and no event loop, then prints timing, throughput, pnl and peak memory.
+// usage: ./backtest_cli es0604.csv es0603.csv [2024-06-04] [2024-06-03] [db] [stream] [nocache]
+// the dates pick the 08:30-15:00 chicago sessions, `db` also streams book snapshots to QuestDB and
+// `stream` parses both files while they replay instead of loading them up front. a loaded csv
+// is mapped from its message cache, written on first use, unless `nocache` is given. files
+// ending in .dbn are read as uncompressed dbn instead of csv
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include "backtest_engine.h"
+#include "dbn.h"
+#include "linear_model_strat.h"
+#include "message_cache.h"
+#include "message_source.h"
+#include "parser.h"
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double peak_rss_mb() {
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+bool is_dbn(const std::string &file_path) {
+    return file_path.size() > 4 && file_path.compare(file_path.size() - 4, 4, ".dbn") == 0;
+}
+
+// the whole day in memory: decoded from dbn, mapped from the csv's cache or parsed
+struct Day {
+    std::vector<message> parsed_;
+    std::unique_ptr<MessageCache> cache_;
+
+    MessageSpan messages() const { return cache_ ? cache_->messages() : MessageSpan(parsed_); }
+};
+
+Day load_day(const char *file_path, size_t threads, bool use_cache) {
+    Day day;
+    if (is_dbn(file_path)) {
+        day.parsed_ = DbnFile(file_path).to_messages();
+    } else if (use_cache) {
+        day.cache_ = std::make_unique<MessageCache>(file_path, threads);
+    } else {
+        Parser parser(file_path);
+        parser.parse(threads);
+        day.parsed_ = std::move(parser.message_stream_);
+    }
+    return day;
+}
+
+// read while the day replays, nullptr if the file could not be opened
+std::unique_ptr<MessageSource> open_stream(const char *file_path) {
+    if (is_dbn(file_path)) {
+        auto source = std::make_unique<DbnSource>(file_path);
+        return source->is_open() ? std::move(source) : nullptr;
+    }
+    auto source = std::make_unique<CsvStreamSource>(file_path);
+    return source->is_open() ? std::move(source) : nullptr;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const char *file_path = argc > 1 ? argv[1] : "es0604.csv";
+    const char *train_file_path = argc > 2 ? argv[2] : "es0603.csv";
+    const std::string date = argc > 3 ? argv[3] : "2024-06-04";
+    const std::string train_date = argc > 4 ? argv[4] : "2024-06-03";
+    bool db_snapshots = false;
+    bool stream = false;
+    bool use_cache = true;
+    for (int i = 5; i < argc; ++i) {
+        db_snapshots = db_snapshots || std::strcmp(argv[i], "db") == 0;
+        stream = stream || std::strcmp(argv[i], "stream") == 0;
+        use_cache = use_cache && std::strcmp(argv[i], "nocache") != 0;
+    }
+
+    std::unique_ptr<MessageSource> messages;
+    std::unique_ptr<MessageSource> train_messages;
+    Day day;
+    Day train_day;
+    if (stream) {
+        messages = open_stream(file_path);
+        train_messages = open_stream(train_file_path);
+        if (!messages || !train_messages) {
+            return 1;
+        }
+    } else {
+        auto start = std::chrono::steady_clock::now();
+        const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        day = load_day(file_path, threads, use_cache);
+        train_day = load_day(train_file_path, threads, use_cache);
+        if (day.messages().empty() || train_day.messages().empty()) {
+            std::fprintf(stderr, "no messages parsed from %s or %s\n", file_path, train_file_path);
+            return 1;
+        }
+        const bool cached = day.cache_ && day.cache_->hit() && train_day.cache_ && train_day.cache_->hit();
+        std::printf("loaded %zu + %zu messages in %.3f s%s\n", day.messages().size(), train_day.messages().size(),
+                    seconds_since(start), cached ? " from the message cache" : "");
+        messages = std::make_unique<VectorSource>(day.messages());
+        train_messages = std::make_unique<VectorSource>(train_day.messages());
+    }
+
+    DatabaseManager db_manager("127.0.0.1", 9009);
+    BacktestEngine engine(db_manager, *messages, *train_messages);
+    engine.set_session(date + " 08:30:00.000", date + " 15:00:00.000");
+    engine.set_train_session(train_date + " 08:30:00.000", train_date + " 15:00:00.000");
+    engine.set_db_snapshots(db_snapshots);
+    engine.add_strategy(std::make_unique<LinearModelStrategy>(db_manager, &engine.book()));
+
+    auto start = std::chrono::steady_clock::now();
+    engine.train_model();
+    std::printf("trained in %.3f s\n", seconds_since(start));
+
+    BacktestStats stats = engine.run();
+    std::printf("warm start: %zu messages in %.3f s\n", stats.warm_start_messages_, stats.warm_start_seconds_);
+    std::printf("replay: %zu messages, %llu events in %.3f s (%.0f msgs/s, %.1f ns/msg)\n", stats.messages_,
+                static_cast<unsigned long long>(stats.events_), stats.seconds_,
+                stats.seconds_ > 0 ? stats.messages_ / stats.seconds_ : 0.0,
+                stats.messages_ > 0 ? stats.seconds_ * 1e9 / stats.messages_ : 0.0);
+
+    for (size_t i = 0; i < engine.strategies().size(); ++i) {
+        const auto &strategy = engine.strategies()[i];
+        std::printf("strategy %zu: pnl %d, position %d\n", i, strategy->get_pnl(), strategy->get_position());
+    }
+    std::printf("peak rss %.1f MB\n", peak_rss_mb());
+    return 0;
+}
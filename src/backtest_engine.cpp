@@ -0,0 +1,253 @@
+#include "backtest_engine.h"
+#include "linear_model_strat.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+BacktestEngine::BacktestEngine(DatabaseManager& db_manager, MessageSpan messages, MessageSpan train_messages)
+        : db_manager_(db_manager), owned_messages_(std::make_unique<VectorSource>(messages)),
+          owned_train_messages_(std::make_unique<VectorSource>(train_messages)),
+          messages_(owned_messages_.get()), train_messages_(owned_train_messages_.get()) {
+    book_ = std::make_unique<Orderbook>(db_manager);
+    train_book_ = std::make_unique<Orderbook>(db_manager);
+}
+
+BacktestEngine::BacktestEngine(DatabaseManager& db_manager, MessageSource& messages, MessageSource& train_messages)
+        : db_manager_(db_manager), messages_(&messages), train_messages_(&train_messages) {
+    book_ = std::make_unique<Orderbook>(db_manager);
+    train_book_ = std::make_unique<Orderbook>(db_manager);
+}
+
+void BacktestEngine::set_session(const std::string& start_time, const std::string& end_time) {
+    start_time_ = start_time;
+    end_time_ = end_time;
+}
+
+void BacktestEngine::set_train_session(const std::string& start_time, const std::string& end_time) {
+    train_start_time_ = start_time;
+    train_end_time_ = end_time;
+}
+
+void BacktestEngine::add_strategy(std::unique_ptr<Strategy> strategy) {
+    strategies_.push_back(std::move(strategy));
+}
+
+void BacktestEngine::train_model() {
+    std::cout << "fitting model..." << std::endl;
+
+    train_book_ = std::make_unique<Orderbook>(db_manager_);
+    train_messages_->rewind();
+    size_t processed = sample_session(*train_book_, *train_messages_, train_start_time_, train_end_time_);
+
+    book_->voi_history_ = std::move(train_book_->voi_history_);
+    book_->mid_prices_ = std::move(train_book_->mid_prices_);
+
+    auto* linear_strategy = strategies_.empty() ? nullptr : dynamic_cast<LinearModelStrategy*>(strategies_[0].get());
+    if (linear_strategy) {
+        linear_strategy->fit_model();
+    }
+
+    std::cout << "model fitted, processed " << processed << " messages." << std::endl;
+}
+
+size_t BacktestEngine::sample_session(Orderbook& book, MessageSpan messages,
+                                      const std::string& start_time, const std::string& end_time) {
+    VectorSource source(messages);
+    return sample_session(book, source, start_time, end_time);
+}
+
+size_t BacktestEngine::sample_session(Orderbook& book, MessageSource& messages,
+                                      const std::string& start_time, const std::string& end_time) {
+    warm_start(book, messages, start_time, "train");
+    const SessionClock& clock = book.clock_;
+    book.clock_.set_session(SessionClock::parse(start_time, clock.zone()), SessionClock::parse(end_time, clock.zone()));
+    // one voi/mid sample per second of exchange time once the session is open
+    TimerWheel timers(SessionClock::NS_PER_MILLI, clock.now());
+    timers.schedule_every(SessionClock::NS_PER_SECOND, clock.session_open() + SessionClock::NS_PER_SECOND,
+                          [](uint64_t, void* context) {
+                              auto* book = static_cast<Orderbook*>(context);
+                              book->calculate_voi();
+                              book->add_mid_price();
+                          }, &book);
+
+    while (const message* msg = messages.next()) {
+        book.process_msg(*msg);
+        // only sample between exchange events
+        if (book.in_event()) {
+            continue;
+        }
+
+        timers.advance(clock.now());
+
+        if (clock.after_close()) {
+            break;
+        }
+    }
+    return messages.position();
+}
+
+size_t BacktestEngine::warm_start(Orderbook& book, MessageSpan messages,
+                                  const std::string& start_time, const std::string& tag,
+                                  const std::string& checkpoint_dir) {
+    uint64_t start_ns = SessionClock::parse(start_time, book.clock_.zone());
+    if (start_ns == 0) {
+        return 0;
+    }
+
+    auto first = std::lower_bound(messages.begin(), messages.end(), start_ns,
+                                  [](const message& msg, uint64_t ns) { return msg.time_ < ns; });
+    size_t start = first - messages.begin();
+    if (start == 0) {
+        return 0;
+    }
+
+    // named after the last pre-session message so a checkpoint never meets a different feed
+    std::string path = checkpoint_dir + "/" + tag + "_" + std::to_string(messages[start - 1].time_) + "_" +
+                       std::to_string(start) + ".ckpt";
+    uint64_t index = 0;
+    if (book.load_checkpoint(path, &index)) {
+        if (index == start) {
+            std::cout << "restored " << start << " pre-session messages from " << path << std::endl;
+            return start;
+        }
+        book.reset();
+    }
+
+    book.process_batch(messages.data(), start);
+    std::error_code ec;
+    std::filesystem::create_directories(checkpoint_dir, ec);
+    book.save_checkpoint(path, start);
+    return start;
+}
+
+size_t BacktestEngine::warm_start(Orderbook& book, MessageSource& messages, const std::string& start_time,
+                                  const std::string& tag, const std::string& checkpoint_dir) {
+    MessageSpan all = messages.messages();
+    if (!all.empty()) {
+        size_t start = warm_start(book, all, start_time, tag, checkpoint_dir);
+        messages.seek(start);
+        return start;
+    }
+
+    uint64_t start_ns = SessionClock::parse(start_time, book.clock_.zone());
+    if (start_ns == 0) {
+        return messages.position();
+    }
+    const message* batch;
+    while (size_t count = messages.peek_batch(batch)) {
+        size_t before_open = std::lower_bound(batch, batch + count, start_ns,
+                                              [](const message& msg, uint64_t ns) { return msg.time_ < ns; }) - batch;
+        book.process_batch(batch, before_open);
+        messages.consume(before_open);
+        if (before_open < count) {
+            break;
+        }
+    }
+    return messages.position();
+}
+
+void BacktestEngine::reset() {
+    messages_->rewind();
+    book_ = std::make_unique<Orderbook>(db_manager_);
+    for (auto& strategy : strategies_) {
+        strategy->set_book(book_.get());
+        strategy->reset();
+    }
+}
+
+void BacktestEngine::schedule_timers() {
+    const SessionClock& clock = book_->clock_;
+    uint64_t from = std::max(clock.session_open(), clock.now());
+    // first whole period after `from`, so a resumed run fires at the same exchange times
+    auto first = [from](uint64_t period) { return (from / period + 1) * period; };
+
+    timers_.reset(clock.now());
+    timers_.schedule_every(STRATEGY_PERIOD_NS, first(STRATEGY_PERIOD_NS), &BacktestEngine::on_strategy_timer, this);
+    if (db_snapshots_) {
+        timers_.schedule_every(DB_SNAPSHOT_PERIOD_NS, first(DB_SNAPSHOT_PERIOD_NS),
+                               &BacktestEngine::on_db_snapshot_timer, this);
+    }
+    if (progress_callback_) {
+        timers_.schedule_every(PROGRESS_PERIOD_NS, first(PROGRESS_PERIOD_NS), &BacktestEngine::on_progress_timer,
+                               this);
+    }
+}
+
+void BacktestEngine::on_strategy_timer(uint64_t, void* context) {
+    auto* self = static_cast<BacktestEngine*>(context);
+    for (auto& strategy: self->strategies_) {
+        strategy->on_book_update();
+
+        while (!strategy->trade_queue_.empty()) {
+            auto [is_buy, price] = strategy->trade_queue_.front();
+            strategy->trade_queue_.pop();
+            if (self->trade_callback_) {
+                self->trade_callback_(self->book_->clock_.format(), is_buy, price, self->trade_context_);
+            }
+        }
+    }
+}
+
+void BacktestEngine::on_db_snapshot_timer(uint64_t, void* context) {
+    auto* self = static_cast<BacktestEngine*>(context);
+    self->db_manager_.update_limit_orderbook(self->book_->bids_, self->book_->offers_);
+}
+
+void BacktestEngine::on_progress_timer(uint64_t, void* context) {
+    auto* self = static_cast<BacktestEngine*>(context);
+    int progress = static_cast<int>(self->messages_->progress() * 100);
+    self->progress_callback_(progress, self->progress_context_);
+}
+
+BacktestStats BacktestEngine::run() {
+    BacktestStats stats{};
+    running_ = true;
+
+    auto warm_start_begin = std::chrono::steady_clock::now();
+    if (messages_->position() == 0) {
+        stats.warm_start_messages_ = warm_start(*book_, *messages_, start_time_, "backtest");
+    }
+    stats.warm_start_seconds_ = seconds_since(warm_start_begin);
+
+    const SessionClock& clock = book_->clock_;
+    book_->clock_.set_session(SessionClock::parse(start_time_, clock.zone()),
+                              SessionClock::parse(end_time_, clock.zone()));
+    schedule_timers();
+
+    size_t first_message = messages_->position();
+    uint64_t first_event = book_->get_event_count();
+    auto replay_begin = std::chrono::steady_clock::now();
+
+    while (running_) {
+        const message* msg = messages_->next();
+        if (!msg) {
+            break;
+        }
+        book_->process_msg(*msg);
+        // strategies, the db and the front end only see the book between exchange events
+        if (book_->in_event()) {
+            continue;
+        }
+
+        timers_.advance(clock.now());
+
+        if (poll_callback_ && clock.after_open()) {
+            poll_callback_(poll_context_);
+        }
+    }
+
+    stats.seconds_ = seconds_since(replay_begin);
+    stats.messages_ = messages_->position() - first_message;
+    stats.events_ = book_->get_event_count() - first_event;
+    running_ = false;
+    return stats;
+}
@@ -0,0 +1,219 @@
+#include "book_manager.h"
+#include <algorithm>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// best effort, a core outside the process' cpuset just leaves the thread unpinned
+void pin_to_core(std::thread &thread, int core) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+    (void) thread;
+    (void) core;
+#endif
+}
+
+}
+
+BookManager::BookManager(DatabaseManager& db_manager, size_t num_shards, std::vector<int> cores,
+                         size_t orders_per_book)
+        : db_manager_(db_manager), orders_per_book_(orders_per_book), shard_of_(1024) {
+    num_shards = std::max<size_t>(num_shards, 1);
+    unsigned hw_cores = std::max(std::thread::hardware_concurrency(), 1u);
+    shards_.reserve(num_shards);
+    for (size_t i = 0; i < num_shards; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->index_ = i;
+        shard->core_ = cores.empty() ? static_cast<int>((i + 1) % hw_cores) : cores[i % cores.size()];
+        shards_.push_back(std::move(shard));
+    }
+}
+
+BookManager::~BookManager() {
+    stop();
+}
+
+void BookManager::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    for (auto& shard: shards_) {
+        Shard* s = shard.get();
+        shard->thread_ = std::thread([this, s] { run_shard(*s); });
+        pin_to_core(shard->thread_, shard->core_);
+    }
+}
+
+void BookManager::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    for (auto& shard: shards_) {
+        if (shard->thread_.joinable()) {
+            shard->thread_.join();
+        }
+    }
+}
+
+void BookManager::enqueue(Shard& shard, const ShardItem& item) {
+    // back-pressure: the submitter waits for the worker instead of dropping messages
+    while (!shard.ring_.enqueue(item)) {
+        cpu_relax();
+    }
+}
+
+void BookManager::submit(const message& msg) {
+    auto [it, inserted] = shard_of_.try_emplace(msg.instrument_id_, static_cast<uint32_t>(next_shard_));
+    if (inserted) {
+        next_shard_ = (next_shard_ + 1) % shards_.size();
+    }
+    enqueue(*shards_[it->second], ShardItem{msg, nullptr});
+    ++sequence_;
+}
+
+void BookManager::submit(const message* msgs, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        submit(msgs[i]);
+    }
+}
+
+uint64_t BookManager::request_snapshot() {
+    auto request = std::make_unique<SnapshotRequest>();
+    request->sequence_ = sequence_;
+    request->shard_parts_.resize(shards_.size());
+    request->remaining_.store(shards_.size(), std::memory_order_relaxed);
+    SnapshotRequest* marker = request.get();
+
+    uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(snapshot_mutex_);
+        ticket = next_ticket_++;
+        snapshots_.emplace(ticket, std::move(request));
+    }
+    for (auto& shard: shards_) {
+        enqueue(*shard, ShardItem{message(0, 0, 0, 0, 0, false), marker});
+    }
+    return ticket;
+}
+
+bool BookManager::poll_snapshot(uint64_t ticket, BookSnapshot& out) {
+    std::unique_ptr<SnapshotRequest> request;
+    {
+        std::lock_guard<std::mutex> lock(snapshot_mutex_);
+        auto it = snapshots_.find(ticket);
+        if (it == snapshots_.end() || it->second->remaining_.load(std::memory_order_acquire) != 0) {
+            return false;
+        }
+        request = std::move(it->second);
+        snapshots_.erase(it);
+    }
+
+    out.sequence_ = request->sequence_;
+    out.instruments_.clear();
+    for (auto& part: request->shard_parts_) {
+        out.instruments_.insert(out.instruments_.end(), part.begin(), part.end());
+    }
+    std::sort(out.instruments_.begin(), out.instruments_.end(),
+              [](const InstrumentSnapshot& a, const InstrumentSnapshot& b) {
+                  return a.instrument_id_ < b.instrument_id_;
+              });
+    return true;
+}
+
+BookSnapshot BookManager::wait_snapshot(uint64_t ticket) {
+    BookSnapshot snapshot;
+    while (!poll_snapshot(ticket, snapshot)) {
+        std::this_thread::yield();
+    }
+    return snapshot;
+}
+
+Orderbook* BookManager::book(uint32_t instrument_id) {
+    auto it = shard_of_.find(instrument_id);
+    if (it == shard_of_.end()) {
+        return nullptr;
+    }
+    Shard& shard = *shards_[it->second];
+    auto slot = shard.book_index_.find(instrument_id);
+    return slot == shard.book_index_.end() ? nullptr : shard.books_[slot->second].get();
+}
+
+uint32_t BookManager::book_slot(Shard& shard, uint32_t instrument_id) {
+    auto [it, inserted] = shard.book_index_.try_emplace(instrument_id, static_cast<uint32_t>(shard.books_.size()));
+    if (inserted) {
+        shard.books_.push_back(std::make_unique<Orderbook>(db_manager_, orders_per_book_));
+        shard.instrument_ids_.push_back(instrument_id);
+        shard.last_times_.push_back(0);
+    }
+    return it->second;
+}
+
+void BookManager::capture(Shard& shard, SnapshotRequest& request) {
+    auto& part = request.shard_parts_[shard.index_];
+    part.reserve(shard.books_.size());
+    for (size_t i = 0; i < shard.books_.size(); ++i) {
+        const Orderbook& book = *shard.books_[i];
+        part.push_back({shard.instrument_ids_[i], book.get_bbo(), book.bid_vol_, book.ask_vol_, book.imbalance_,
+                        book.vwap_, shard.last_times_[i], static_cast<uint64_t>(book.ct_)});
+    }
+    request.remaining_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void BookManager::capture_pending(Shard& shard) {
+    for (SnapshotRequest* request: shard.pending_) {
+        capture(shard, *request);
+    }
+    shard.pending_.clear();
+}
+
+void BookManager::run_shard(Shard& shard) {
+    while (true) {
+        auto item = shard.ring_.dequeue();
+        if (!item) {
+            // the submitter's last enqueue happens before it clears running_
+            if (!running_.load(std::memory_order_acquire) && shard.ring_.empty()) {
+                // a stream cut off inside an event still answers its snapshots
+                capture_pending(shard);
+                break;
+            }
+            cpu_relax();
+            continue;
+        }
+        if (item->snapshot_) {
+            shard.pending_.push_back(item->snapshot_);
+            if (shard.open_events_ == 0) {
+                capture_pending(shard);
+            }
+            continue;
+        }
+        const message& msg = item->msg_;
+        uint32_t slot = book_slot(shard, msg.instrument_id_);
+        Orderbook& book = *shard.books_[slot];
+        const bool was_open = book.in_event();
+        book.process_msg(msg);
+        shard.last_times_[slot] = msg.time_;
+        if (book.in_event() != was_open) {
+            was_open ? --shard.open_events_ : ++shard.open_events_;
+        }
+        if (!shard.pending_.empty() && shard.open_events_ == 0) {
+            capture_pending(shard);
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#include "checkpoint.h"
+#include <cstring>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+CheckpointView::CheckpointView(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return;
+    }
+
+    struct stat sb;
+    if (fstat(fd, &sb) == -1 || static_cast<size_t>(sb.st_size) < sizeof(CheckpointHeader)) {
+        close(fd);
+        return;
+    }
+
+    size_ = sb.st_size;
+    void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "error mapping checkpoint: " << path << std::endl;
+        return;
+    }
+    mapped_ = mapped;
+
+    auto* header = static_cast<const CheckpointHeader*>(mapped_);
+    if (std::memcmp(header->magic_, MAGIC, sizeof(MAGIC)) != 0 || header->version_ != VERSION) {
+        std::cerr << "not a version " << VERSION << " checkpoint: " << path << std::endl;
+        return;
+    }
+    size_t expected = sizeof(CheckpointHeader) + header->level_count_ * sizeof(CheckpointLevel) +
+                      header->order_count_ * sizeof(CheckpointOrder);
+    if (size_ != expected) {
+        std::cerr << "truncated checkpoint: " << path << std::endl;
+        return;
+    }
+
+    auto* bytes = static_cast<const char*>(mapped_);
+    auto* levels = reinterpret_cast<const CheckpointLevel*>(bytes + sizeof(CheckpointHeader));
+    uint64_t orders = 0;
+    for (uint32_t i = 0; i < header->level_count_; ++i) {
+        orders += levels[i].order_count_;
+    }
+    if (orders != header->order_count_) {
+        std::cerr << "corrupt checkpoint: " << path << std::endl;
+        return;
+    }
+
+    levels_ = levels;
+    orders_ = reinterpret_cast<const CheckpointOrder*>(bytes + sizeof(CheckpointHeader) +
+                                                       header->level_count_ * sizeof(CheckpointLevel));
+    header_ = header;
+}
+
+CheckpointView::~CheckpointView() {
+    if (mapped_) {
+        munmap(mapped_, size_);
+    }
+}
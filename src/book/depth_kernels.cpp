@@ -0,0 +1,258 @@
+#include <initializer_list>
+#include "depth_kernels.h"
+
+#if !defined(ORDERBOOK_SIMD_SCALAR) && (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define ORDERBOOK_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+#if !defined(ORDERBOOK_SIMD_SCALAR) && defined(__ARM_NEON) && defined(__aarch64__)
+#define ORDERBOOK_NEON_KERNELS 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+double weighted_sum_scalar(const uint32_t *volumes, const double *weights, size_t n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += static_cast<double>(volumes[i]) * weights[i];
+    }
+    return sum;
+}
+
+void cumulative_scalar(const uint32_t *volumes, uint32_t *out, size_t n) {
+    uint32_t running = 0;
+    for (size_t i = 0; i < n; ++i) {
+        running += volumes[i];
+        out[i] = running;
+    }
+}
+
+void imbalance_scalar(const uint32_t *bid, const uint32_t *ask, double *out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        double b = static_cast<double>(bid[i]);
+        double a = static_cast<double>(ask[i]);
+        double total = b + a;
+        out[i] = total == 0.0 ? 0.0 : (b - a) / total;
+    }
+}
+
+// the vector loops hand their remainder to the scalar kernels above
+inline void cumulative_tail(const uint32_t *volumes, uint32_t *out, size_t i, size_t n) {
+    uint32_t running = i > 0 ? out[i - 1] : 0;
+    for (; i < n; ++i) {
+        running += volumes[i];
+        out[i] = running;
+    }
+}
+
+const DepthKernels SCALAR_KERNELS = {SimdBackend::Scalar, "scalar", weighted_sum_scalar, cumulative_scalar,
+                                     imbalance_scalar};
+
+#ifdef ORDERBOOK_X86_KERNELS
+
+__attribute__((target("sse4.2")))
+double weighted_sum_sse42(const uint32_t *volumes, const double *weights, size_t n) {
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(volumes + i));
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_cvtepi32_pd(v), _mm_loadu_pd(weights + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(v, 8)), _mm_loadu_pd(weights + i + 2)));
+    }
+    acc0 = _mm_add_pd(acc0, acc1);
+    double sum = _mm_cvtsd_f64(acc0) + _mm_cvtsd_f64(_mm_unpackhi_pd(acc0, acc0));
+    return sum + weighted_sum_scalar(volumes + i, weights + i, n - i);
+}
+
+__attribute__((target("sse4.2")))
+void cumulative_sse42(const uint32_t *volumes, uint32_t *out, size_t n) {
+    __m128i carry = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(volumes + i));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, carry);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), x);
+        carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    cumulative_tail(volumes, out, i, n);
+}
+
+__attribute__((target("sse4.2")))
+inline __m128d imbalance2_sse42(__m128d b, __m128d a) {
+    __m128d total = _mm_add_pd(b, a);
+    __m128d ratio = _mm_div_pd(_mm_sub_pd(b, a), total);
+    return _mm_andnot_pd(_mm_cmpeq_pd(total, _mm_setzero_pd()), ratio);
+}
+
+__attribute__((target("sse4.2")))
+void imbalance_sse42(const uint32_t *bid, const uint32_t *ask, double *out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bid + i));
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ask + i));
+        _mm_storeu_pd(out + i, imbalance2_sse42(_mm_cvtepi32_pd(b), _mm_cvtepi32_pd(a)));
+        _mm_storeu_pd(out + i + 2, imbalance2_sse42(_mm_cvtepi32_pd(_mm_srli_si128(b, 8)),
+                                                    _mm_cvtepi32_pd(_mm_srli_si128(a, 8))));
+    }
+    imbalance_scalar(bid + i, ask + i, out + i, n - i);
+}
+
+__attribute__((target("avx2")))
+double weighted_sum_avx2(const uint32_t *volumes, const double *weights, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(volumes + i));
+        __m256d lo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(v));
+        __m256d hi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1));
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(lo, _mm256_loadu_pd(weights + i)));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(hi, _mm256_loadu_pd(weights + i + 4)));
+    }
+    __m256d acc = _mm256_add_pd(acc0, acc1);
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    double sum = _mm_cvtsd_f64(half) + _mm_cvtsd_f64(_mm_unpackhi_pd(half, half));
+    return sum + weighted_sum_scalar(volumes + i, weights + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void cumulative_avx2(const uint32_t *volumes, uint32_t *out, size_t n) {
+    const __m256i lane3 = _mm256_set1_epi32(3);
+    const __m256i lane7 = _mm256_set1_epi32(7);
+    __m256i carry = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(volumes + i));
+        // prefix sum inside each 128-bit lane, then push the low lane total into the high lane
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+        __m256i low_total = _mm256_permutevar8x32_epi32(x, lane3);
+        x = _mm256_add_epi32(x, _mm256_blend_epi32(_mm256_setzero_si256(), low_total, 0xF0));
+        x = _mm256_add_epi32(x, carry);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), x);
+        carry = _mm256_permutevar8x32_epi32(x, lane7);
+    }
+    cumulative_tail(volumes, out, i, n);
+}
+
+__attribute__((target("avx2")))
+inline __m256d imbalance4_avx2(__m256d b, __m256d a) {
+    __m256d total = _mm256_add_pd(b, a);
+    __m256d ratio = _mm256_div_pd(_mm256_sub_pd(b, a), total);
+    return _mm256_andnot_pd(_mm256_cmp_pd(total, _mm256_setzero_pd(), _CMP_EQ_OQ), ratio);
+}
+
+__attribute__((target("avx2")))
+void imbalance_avx2(const uint32_t *bid, const uint32_t *ask, double *out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bid + i));
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ask + i));
+        _mm256_storeu_pd(out + i, imbalance4_avx2(_mm256_cvtepi32_pd(_mm256_castsi256_si128(b)),
+                                                  _mm256_cvtepi32_pd(_mm256_castsi256_si128(a))));
+        _mm256_storeu_pd(out + i + 4, imbalance4_avx2(_mm256_cvtepi32_pd(_mm256_extracti128_si256(b, 1)),
+                                                      _mm256_cvtepi32_pd(_mm256_extracti128_si256(a, 1))));
+    }
+    imbalance_scalar(bid + i, ask + i, out + i, n - i);
+}
+
+const DepthKernels SSE42_KERNELS = {SimdBackend::SSE42, "sse4.2", weighted_sum_sse42, cumulative_sse42,
+                                    imbalance_sse42};
+const DepthKernels AVX2_KERNELS = {SimdBackend::AVX2, "avx2", weighted_sum_avx2, cumulative_avx2, imbalance_avx2};
+
+#endif
+
+#ifdef ORDERBOOK_NEON_KERNELS
+
+double weighted_sum_neon(const uint32_t *volumes, const double *weights, size_t n) {
+    float64x2_t acc0 = vdupq_n_f64(0.0);
+    float64x2_t acc1 = vdupq_n_f64(0.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint32x4_t v = vld1q_u32(volumes + i);
+        acc0 = vfmaq_f64(acc0, vcvtq_f64_u64(vmovl_u32(vget_low_u32(v))), vld1q_f64(weights + i));
+        acc1 = vfmaq_f64(acc1, vcvtq_f64_u64(vmovl_high_u32(v)), vld1q_f64(weights + i + 2));
+    }
+    double sum = vaddvq_f64(vaddq_f64(acc0, acc1));
+    return sum + weighted_sum_scalar(volumes + i, weights + i, n - i);
+}
+
+void cumulative_neon(const uint32_t *volumes, uint32_t *out, size_t n) {
+    const uint32x4_t zero = vdupq_n_u32(0);
+    uint32x4_t carry = zero;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint32x4_t x = vld1q_u32(volumes + i);
+        x = vaddq_u32(x, vextq_u32(zero, x, 3));
+        x = vaddq_u32(x, vextq_u32(zero, x, 2));
+        x = vaddq_u32(x, carry);
+        vst1q_u32(out + i, x);
+        carry = vdupq_laneq_u32(x, 3);
+    }
+    cumulative_tail(volumes, out, i, n);
+}
+
+inline float64x2_t imbalance2_neon(float64x2_t b, float64x2_t a) {
+    float64x2_t total = vaddq_f64(b, a);
+    float64x2_t ratio = vdivq_f64(vsubq_f64(b, a), total);
+    return vbslq_f64(vceqzq_f64(total), vdupq_n_f64(0.0), ratio);
+}
+
+void imbalance_neon(const uint32_t *bid, const uint32_t *ask, double *out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint32x4_t b = vld1q_u32(bid + i);
+        uint32x4_t a = vld1q_u32(ask + i);
+        vst1q_f64(out + i, imbalance2_neon(vcvtq_f64_u64(vmovl_u32(vget_low_u32(b))),
+                                           vcvtq_f64_u64(vmovl_u32(vget_low_u32(a)))));
+        vst1q_f64(out + i + 2, imbalance2_neon(vcvtq_f64_u64(vmovl_high_u32(b)),
+                                               vcvtq_f64_u64(vmovl_high_u32(a))));
+    }
+    imbalance_scalar(bid + i, ask + i, out + i, n - i);
+}
+
+const DepthKernels NEON_KERNELS = {SimdBackend::NEON, "neon", weighted_sum_neon, cumulative_neon, imbalance_neon};
+
+#endif
+
+const DepthKernels &select_kernels() {
+    for (SimdBackend backend: {SimdBackend::AVX2, SimdBackend::NEON, SimdBackend::SSE42}) {
+        if (const DepthKernels *kernels = depth_kernels_for(backend)) {
+            return *kernels;
+        }
+    }
+    return SCALAR_KERNELS;
+}
+
+}
+
+const DepthKernels *depth_kernels_for(SimdBackend backend) {
+    switch (backend) {
+        case SimdBackend::Scalar:
+            return &SCALAR_KERNELS;
+#ifdef ORDERBOOK_X86_KERNELS
+        case SimdBackend::SSE42:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse4.2") ? &SSE42_KERNELS : nullptr;
+        case SimdBackend::AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") ? &AVX2_KERNELS : nullptr;
+#endif
+#ifdef ORDERBOOK_NEON_KERNELS
+        case SimdBackend::NEON:
+            return &NEON_KERNELS;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+const DepthKernels &depth_kernels() {
+    static const DepthKernels &kernels = select_kernels();
+    return kernels;
+}
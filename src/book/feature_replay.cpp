@@ -0,0 +1,127 @@
+#include "feature_replay.h"
+#include "snapshot_index.h"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+namespace {
+
+constexpr uint64_t NS_PER_SECOND = 1000000000ULL;
+
+SecondFeatures sample(const Orderbook& book, uint64_t second) {
+    SecondFeatures row{};
+    row.second_ = second;
+    row.bbo_ = book.get_bbo();
+    row.mid_price_ = book.get_mid_price();
+    row.imbalance_ = book.imbalance_;
+    row.bid_vol_ = book.bid_vol_;
+    row.ask_vol_ = book.ask_vol_;
+    row.message_count_ = static_cast<uint64_t>(book.ct_);
+    return row;
+}
+
+// replays messages[begin, end) into `book`, which holds the state before `begin`, adding a row
+// each time the exchange second changes between two events and one for the last second of
+// the range
+void replay_chunk(Orderbook& book, const std::vector<message>& messages, size_t begin, size_t end,
+                  std::vector<SecondFeatures>& rows) {
+    if (begin == end) {
+        return;
+    }
+    uint64_t second = messages[begin].time_ / NS_PER_SECOND;
+    for (size_t i = begin; i < end; ++i) {
+        uint64_t msg_second = messages[i].time_ / NS_PER_SECOND;
+        if (msg_second != second && !book.in_event()) {
+            rows.push_back(sample(book, second));
+            second = msg_second;
+        }
+        book.process_msg(messages[i]);
+    }
+    rows.push_back(sample(book, second));
+}
+
+}
+
+std::vector<SecondFeatures> extract_second_features(DatabaseManager& db_manager, const std::vector<message>& messages,
+                                                    const std::string& index_dir, size_t threads,
+                                                    uint32_t index_interval_seconds) {
+    std::vector<SecondFeatures> features;
+    if (messages.empty()) {
+        return features;
+    }
+
+    // chunk starts: 0 plus a snapshot close to every k * size / threads
+    std::vector<size_t> starts = {0};
+    if (threads > 1) {
+        SnapshotIndex index(index_dir);
+        if (!index.matches(messages)) {
+            Orderbook scratch(db_manager);
+            if (SnapshotIndex::build(scratch, messages, index_dir, index_interval_seconds)) {
+                index = SnapshotIndex(index_dir);
+            }
+        }
+        if (index.matches(messages)) {
+            const auto& snapshots = index.snapshots();
+            for (size_t k = 1; k < threads; ++k) {
+                size_t target = messages.size() * k / threads;
+                auto it = std::lower_bound(snapshots.begin(), snapshots.end(), target,
+                                           [](const SnapshotEntry& entry, size_t position) {
+                                               return entry.message_index_ < position;
+                                           });
+                if (it != snapshots.end() && it->message_index_ > starts.back()) {
+                    starts.push_back(it->message_index_);
+                }
+            }
+        } else {
+            std::cerr << "no snapshot index in " << index_dir << ", replaying serially" << std::endl;
+        }
+    }
+    starts.push_back(messages.size());
+
+    const size_t chunks = starts.size() - 1;
+    std::vector<std::vector<SecondFeatures>> chunk_rows(chunks);
+    auto run = [&](size_t chunk) {
+        auto book = std::make_unique<Orderbook>(db_manager);
+        size_t begin = starts[chunk];
+        uint64_t restored = 0;
+        if (begin != 0 && !(book->load_checkpoint(SnapshotIndex::snapshot_path(index_dir, begin), &restored) &&
+                            restored == begin)) {
+            // snapshot went missing since the index was read, rebuild the prefix instead
+            book->reset();
+            book->process_batch(messages.data(), begin);
+        }
+        replay_chunk(*book, messages, begin, starts[chunk + 1], chunk_rows[chunk]);
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        workers.emplace_back(run, chunk);
+    }
+    run(0);
+    for (auto& worker: workers) {
+        worker.join();
+    }
+
+    size_t total = 0;
+    for (const auto& rows: chunk_rows) {
+        total += rows.size();
+    }
+    features.reserve(total);
+    for (auto& rows: chunk_rows) {
+        // a snapshot held back to the end of an event can split a second between two chunks,
+        // the later chunk has the state at the end of it
+        if (!features.empty() && !rows.empty() && features.back().second_ == rows.front().second_) {
+            features.pop_back();
+        }
+        features.insert(features.end(), rows.begin(), rows.end());
+    }
+
+    // voi needs the previous row, which may belong to another chunk
+    Bbo prev;
+    for (auto& row: features) {
+        row.voi_ = order_imbalance(prev, row.bbo_);
+        prev = row.bbo_;
+    }
+    return features;
+}
@@ -1,22 +1,16 @@
-
 #include "limit.h"
 
 Limit::Limit(int32_t price) {
     volume_ = 0;
     num_orders_ = 0;
     price_ = price;
-    head_ = nullptr;
-    tail_ = nullptr;
+    head_ = Order::NULL_ORDER;
+    tail_ = Order::NULL_ORDER;
+    handle_ = Order::NULL_ORDER;
+    side_ = false;
 }
 
-Limit::Limit(Order* new_order) :
-        price_(new_order->price_),
-        volume_(new_order->size),
-        num_orders_(1),
-        head_(new_order),
-        tail_(new_order) {};
-
-
+Limit::Limit() : Limit(0) {}
 
 void Limit::set(int32_t price) { this->price_ = price; }
 
@@ -24,12 +18,9 @@ void Limit::reset() {
     this->price_ = 0;
     this->volume_ = 0;
     this->num_orders_ = 0;
-    this->head_ = nullptr;
-    this->tail_ = nullptr;
+    this->head_ = Order::NULL_ORDER;
+    this->tail_ = Order::NULL_ORDER;
 }
 
 
-bool Limit::is_empty() { return head_ == nullptr && tail_ == nullptr; }
-
-
-
+bool Limit::is_empty() { return head_ == Order::NULL_ORDER; }
@@ -1,22 +1,30 @@
-
-/*
 #include "limit_pool.h"
 
-limit* limit_pool::acquire_limit(float price) {
-    auto& limit_ptr = limits_by_price_[price];
-    if (!limit_ptr) {
-        limit_ptr = std::make_unique<limit>(price);
+LimitPool::LimitPool(size_t initial_size) : free_list_(Order::NULL_ORDER) {
+    slabs_.reserve((initial_size + SLAB_SIZE - 1) / SLAB_SIZE);
+    while (slabs_.size() * SLAB_SIZE < initial_size) {
+        add_slab();
     }
-    limit_ptr->set(price);
-    return limit_ptr.get();
 }
 
-void limit_pool::release_limit(limit *curr) {
-    auto it = limits_by_price_.find(curr->price_);
-    if (it != limits_by_price_.end()) {
-        it->second->reset();
+void LimitPool::add_slab() {
+    auto slab_index = static_cast<uint32_t>(slabs_.size());
+    slabs_.push_back(std::make_unique<Limit[]>(SLAB_SIZE));
+    Limit* slab = slabs_.back().get();
+    for (uint32_t i = SLAB_SIZE; i-- > 0;) {
+        slab[i].handle_ = (slab_index << SLAB_BITS) | i;
+        slab[i].next_free_ = free_list_;
+        free_list_ = slab[i].handle_;
     }
 }
 
-
-*/
\ No newline at end of file
+void LimitPool::reset() {
+    free_list_ = Order::NULL_ORDER;
+    for (auto it = slabs_.rbegin(); it != slabs_.rend(); ++it) {
+        Limit* slab = it->get();
+        for (uint32_t i = SLAB_SIZE; i-- > 0;) {
+            slab[i].next_free_ = free_list_;
+            free_list_ = slab[i].handle_;
+        }
+    }
+}
@@ -1,13 +1,34 @@
-
 #include "order_pool.h"
 
-OrderPool::OrderPool(size_t initial_size) {
-    pool_.reserve(initial_size);
-    available_orders_.reserve(initial_size);
-    for (size_t i = 0; i < initial_size; ++i) {
-        pool_.push_back(std::make_unique<Order>());
-        available_orders_.push_back(pool_.back().get());
+OrderPool::OrderPool(size_t initial_size) : free_list_(NULL_HANDLE) {
+    slabs_.reserve((initial_size + SLAB_SIZE - 1) / SLAB_SIZE);
+    info_slabs_.reserve((initial_size + SLAB_SIZE - 1) / SLAB_SIZE);
+    while (capacity() < initial_size) {
+        add_slab();
     }
 }
 
+void OrderPool::add_slab() {
+    auto slab_index = static_cast<uint32_t>(slabs_.size());
+    slabs_.push_back(std::make_unique<Order[]>(SLAB_SIZE));
+    info_slabs_.push_back(std::make_unique<OrderInfo[]>(SLAB_SIZE));
+    Order* slab = slabs_.back().get();
+    // thread the free list front to back so consecutive allocations are adjacent in memory
+    for (uint32_t i = SLAB_SIZE; i-- > 0;) {
+        slab[i].next_ = free_list_;
+        free_list_ = (slab_index << SLAB_BITS) | i;
+    }
+}
 
+void OrderPool::reset() {
+    free_list_ = NULL_HANDLE;
+    for (auto s = static_cast<uint32_t>(slabs_.size()); s-- > 0;) {
+        Order* slab = slabs_[s].get();
+        for (uint32_t i = SLAB_SIZE; i-- > 0;) {
+            slab[i].next_ = free_list_;
+            slab[i].prev_ = NULL_HANDLE;
+            slab[i].parent_ = NULL_HANDLE;
+            free_list_ = (s << SLAB_BITS) | i;
+        }
+    }
+}
@@ -1,32 +1,30 @@
 #include <iostream>
 #include <iomanip>
 #include <numeric>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
 #include "orderbook.h"
 
-Orderbook::Orderbook(DatabaseManager& db_manager)
-        : db_manager_(db_manager), order_pool_(1000000), bid_count_(0), ask_count_(0) {
-    bids_.get_allocator().allocate(1000);
-    offers_.get_allocator().allocate(1000);
-    order_lookup_.reserve(1000000);
-    limit_lookup_.reserve(2000);
+Orderbook::Orderbook(DatabaseManager& db_manager, size_t order_capacity, int32_t tick_size)
+        : db_manager_(db_manager), order_pool_(order_capacity), limit_pool_(4096), bid_count_(0), ask_count_(0),
+          bids_(BookSide<true>::make(tick_size)), offers_(BookSide<false>::make(tick_size)),
+          order_lookup_(65536, true) {
     ct_ = 0;
+    bid_vol_ = 0;
+    ask_vol_ = 0;
+    imbalance_ = 0.0;
+    vwap_ = 0.0;
+    sum1_ = 0.0;
+    sum2_ = 0.0;
     voi_history_.reserve(40000);
 }
 
 Orderbook::~Orderbook() {
-    for (auto& pair : bids_) {
-        delete pair.second;
-    }
     bids_.clear();
-
-    for (auto& pair : offers_) {
-        delete pair.second;
-    }
     offers_.clear();
-
     order_lookup_.clear();
-    limit_lookup_.clear();
-
 }
 
 
@@ -39,34 +37,112 @@ typename BookSide<Side>::MapType& Orderbook::get_book_side() {
     }
 }
 
+// the side container doubles as the price -> Limit index (a direct slot lookup for the ladder backend)
 template<bool Side>
 Limit* Orderbook::get_or_insert_limit(int32_t price) {
-    std::pair<int32_t, bool> key = std::make_pair(price, Side);
-    auto it = limit_lookup_.find(key);
-    if (it == limit_lookup_.end()) {
-        auto* new_limit = new Limit(price);
-        get_book_side<Side>()[price] = new_limit;
-        new_limit->side_ = Side;
-        limit_lookup_[key] = new_limit;
-        return new_limit;
-    } else {
+    auto& side = get_book_side<Side>();
+    auto it = side.find(price);
+    if (it != side.end()) {
         return it->second;
     }
+    auto* new_limit = limit_pool_.get_limit(price);
+    new_limit->side_ = Side;
+    side.emplace(price, new_limit);
+    get_depth<Side>().on_level_added(side, price);
+    return new_limit;
 }
 
+template<bool Side>
+void Orderbook::erase_limit(Limit* limit) {
+    auto& side = get_book_side<Side>();
+    int32_t price = limit->price_;
+    side.erase(price);
+    get_depth<Side>().on_level_removed(side, price);
+    limit_pool_.return_limit(limit);
+}
 
 template<bool Side>
-void Orderbook::add_limit_order(uint64_t id, int32_t price, uint32_t size, uint64_t unix_time) {
-    Order* new_order = order_pool_.get_order();
-    new_order->id_ = id;
+void Orderbook::sync_depth() {
+    if constexpr (Side) {
+        bid_vol_ = static_cast<int32_t>(bid_top_.volume());
+    } else {
+        ask_vol_ = static_cast<int32_t>(ask_top_.volume());
+    }
+}
+
+// a level worse than the cached touch cannot move it, everything else re-reads begin()
+template<bool Side>
+void Orderbook::update_bbo(int32_t price) {
+    int32_t& best_price = Side ? bbo_.bid_price_ : bbo_.ask_price_;
+    uint64_t& best_volume = Side ? bbo_.bid_volume_ : bbo_.ask_volume_;
+    uint32_t& best_orders = Side ? bbo_.bid_orders_ : bbo_.ask_orders_;
+    if (best_orders != 0 && (Side ? price < best_price : price > best_price)) {
+        return;
+    }
+
+    auto& side = get_book_side<Side>();
+    int32_t new_price = 0;
+    uint64_t new_volume = 0;
+    uint32_t new_orders = 0;
+    if (!side.empty()) {
+        auto it = side.begin();
+        new_price = it->first;
+        new_volume = it->second->volume_;
+        new_orders = it->second->num_orders_;
+    }
+    if (new_price == best_price && new_volume == best_volume && new_orders == best_orders) {
+        return;
+    }
+    best_price = new_price;
+    best_volume = new_volume;
+    best_orders = new_orders;
+    bbo_changed_ = true;
+}
+
+void Orderbook::publish_bbo() {
+    if (!bbo_changed_) {
+        return;
+    }
+    bbo_changed_ = false;
+    // an event can move the touch and put it back
+    if (bbo_ == published_bbo_) {
+        return;
+    }
+    published_bbo_ = bbo_;
+    ++bbo_version_;
+    if (bbo_callback_) {
+        bbo_callback_(bbo_, bbo_context_);
+    }
+}
+
+void Orderbook::end_event() {
+    in_event_ = false;
+    ++event_count_;
+    calculate_imbalance();
+    publish_bbo();
+    if (event_callback_) {
+        event_callback_(*this, event_context_);
+    }
+}
+
+
+template<bool Side>
+uint32_t Orderbook::create_order(uint64_t id, int32_t price, uint32_t size, uint64_t unix_time) {
+    uint32_t handle = order_pool_.acquire();
+    Order* new_order = order_pool_.at(handle);
     new_order->price_ = price;
     new_order->size = size;
     new_order->side_ = Side;
-    new_order->unix_time_ = unix_time;
+
+    OrderInfo& info = order_pool_.info(handle);
+    info.id_ = id;
+    info.unix_time_ = unix_time;
 
     Limit* curr_limit = get_or_insert_limit<Side>(price);
-    order_lookup_[id] = new_order;
-    curr_limit->add_order(new_order);
+    curr_limit->add_order(handle, order_pool_);
+    get_depth<Side>().on_volume(price, size);
+    sync_depth<Side>();
+    update_bbo<Side>(price);
 
     if constexpr (Side) {
         ++bid_count_;
@@ -74,22 +150,32 @@ void Orderbook::add_limit_order(uint64_t id, int32_t price, uint32_t size, uint6
         ++ask_count_;
     }
 
-    //update_vol<Side>(price, size, true);
+    return handle;
+}
+
+template<bool Side>
+void Orderbook::add_limit_order(uint64_t id, int32_t price, uint32_t size, uint64_t unix_time) {
+    order_lookup_.insert_or_assign(id, create_order<Side>(id, price, size, unix_time));
 }
 
 
 template<bool Side>
-void Orderbook::remove_order(uint64_t id, int32_t price, uint32_t size) {
-    auto target = order_lookup_[id];
-    auto curr_limit = target->parent_;
-    order_lookup_.erase(id);
-    curr_limit->remove_order(target);
+void Orderbook::remove_order(uint64_t id) {
+    auto it = order_lookup_.find(id);
+    if (it == order_lookup_.end()) {
+        return;
+    }
+    uint32_t handle = it->second;
+    Order* target = order_pool_.at(handle);
+    Limit* curr_limit = limit_pool_.at(target->parent_);
+    order_lookup_.erase(it);
+    curr_limit->remove_order(handle, order_pool_);
+    get_depth<Side>().on_volume(target->price_, -static_cast<int64_t>(target->size));
     if (curr_limit->is_empty()) {
-        get_book_side<Side>().erase(price);
-        std::pair<int32_t, bool> key = std::make_pair(price, Side);
-        limit_lookup_.erase(key);
-        target->parent_ = nullptr;
+        erase_limit<Side>(curr_limit);
     }
+    sync_depth<Side>();
+    update_bbo<Side>(target->price_);
 
     if constexpr (Side) {
         --bid_count_;
@@ -97,46 +183,53 @@ void Orderbook::remove_order(uint64_t id, int32_t price, uint32_t size) {
         --ask_count_;
     }
 
-    //update_vol<Side>(price, size, false);
-    order_pool_.return_order(target);
+    order_pool_.release(handle);
 }
 
 
 template<bool Side>
 void Orderbook::modify_order(uint64_t id, int32_t new_price, uint32_t new_size, uint64_t unix_time) {
-    if (order_lookup_.find(id) == order_lookup_.end()) {
-        add_limit_order<Side>(id, new_price, new_size, unix_time);
+    auto [it, inserted] = order_lookup_.try_emplace(id, OrderPool::NULL_HANDLE);
+    if (inserted) {
+        it->second = create_order<Side>(id, new_price, new_size, unix_time);
         return;
     }
 
-    Order* target = order_lookup_[id];
+    uint32_t handle = it->second;
+    Order* target = order_pool_.at(handle);
     auto prev_price = target->price_;
-    auto prev_limit = target->parent_;
+    auto prev_limit = limit_pool_.at(target->parent_);
     auto prev_size = target->size;
+    order_pool_.info(handle).unix_time_ = unix_time;
 
+    auto& depth = get_depth<Side>();
     if (prev_price != new_price) {
-        prev_limit->remove_order(target);
+        prev_limit->remove_order(handle, order_pool_);
+        depth.on_volume(prev_price, -static_cast<int64_t>(prev_size));
         if (prev_limit->is_empty()) {
-            get_book_side<Side>().erase(prev_price);
-            std::pair<int32_t, bool> key = std::make_pair(prev_price, Side);
-            limit_lookup_.erase(key);
+            erase_limit<Side>(prev_limit);
         }
         Limit* new_limit = get_or_insert_limit<Side>(new_price);
         target->size = new_size;
         target->price_ = new_price;
-        target->unix_time_ = unix_time;
-        new_limit->add_order(target);
+        new_limit->add_order(handle, order_pool_);
+        depth.on_volume(new_price, new_size);
     } else if (prev_size < new_size) {
-        prev_limit->remove_order(target);
+        prev_limit->remove_order(handle, order_pool_);
         target->size = new_size;
-        target->unix_time_ = unix_time;
-        prev_limit->add_order(target);
+        prev_limit->add_order(handle, order_pool_);
+        depth.on_volume(new_price, new_size - prev_size);
     } else {
+        // a size decrease keeps queue priority, only the level volume shrinks
         target->size = new_size;
-        target->unix_time_ = unix_time;
+        prev_limit->volume_ -= prev_size - new_size;
+        depth.on_volume(new_price, -static_cast<int64_t>(prev_size - new_size));
+    }
+    sync_depth<Side>();
+    update_bbo<Side>(prev_price);
+    if (prev_price != new_price) {
+        update_bbo<Side>(new_price);
     }
-
-    //update_modify_vol<Side>(prev_price, new_price, prev_size, new_size);
 }
 
 template<bool Side>
@@ -148,17 +241,26 @@ void Orderbook::trade_order(uint64_t id, int32_t price, uint32_t size) {
         return;
     }
 
-    auto trade_limit = get_or_insert_limit<!Side>(price);
-    auto it = trade_limit->head_;
+    auto limit_it = opposite_side.find(price);
+    if (limit_it == opposite_side.end()) {
+        calculate_vwap(price, og_size);
+        return;
+    }
+    Limit* limit = limit_it->second;
+    uint32_t handle = limit->head_;
 
-    while (it != nullptr) {
+    while (handle != Order::NULL_ORDER) {
+        Order* it = order_pool_.at(handle);
         if (size == it->size) {
             it->filled_ = true;
             size = 0;
             break;
         } else if (size < it->size) {
             it->size -= size;
-            get_volume<!Side>() -= size;
+            limit->volume_ -= size;
+            get_depth<!Side>().on_volume(price, -static_cast<int64_t>(size));
+            sync_depth<!Side>();
+            update_bbo<!Side>(price);
             size = 0;
             break;
         } else {
@@ -167,108 +269,80 @@ void Orderbook::trade_order(uint64_t id, int32_t price, uint32_t size) {
             if (size == 0) {
                 break;
             }
-            it = it->next_;
+            handle = it->next_;
         }
     }
     calculate_vwap(price, og_size);
 
 }
 
-template<bool Side>
-int32_t& Orderbook::get_volume()  {
-    if constexpr (Side) {
-        return bid_vol_;
-    } else {
-        return ask_vol_;
-    }
+void Orderbook::calculate_skew() {
+    skew_ = log10(get_bid_depth()) - log10(get_ask_depth());
 }
 
 
-template<bool Side>
-void Orderbook::update_vol(int32_t price, int32_t size, bool is_add) {
-    if (!update_possible) {
+void Orderbook::calculate_imbalance() {
+    uint64_t total_vol = bid_vol_ + ask_vol_;
+    if (total_vol == 0) {
+        imbalance_ = 0.0;
         return;
     }
-
-    int32_t& vol = Side ? bid_vol_ : ask_vol_;
-    int32_t best_price = Side ? get_best_bid_price() : get_best_ask_price();
-
-    if (std::abs(price - best_price) <= 2000) {
-        vol += is_add ? size : -size;
-    }
+    imbalance_ = static_cast<double>(static_cast<int64_t>(bid_vol_) - static_cast<int64_t>(ask_vol_)) / static_cast<double>(total_vol);
 }
 
 template<bool Side>
-void Orderbook::update_modify_vol(int32_t og_price, int32_t new_price, int32_t og_size, int32_t new_size) {
-    if (!update_possible) {
-        return;
-    }
-
-    int32_t best_price = Side ? get_best_bid_price() : get_best_ask_price();
-    int32_t& vol = Side ? bid_vol_ : ask_vol_;
-
-    int32_t og_in_range = (std::abs(og_price - best_price) <= 2000);
-    int32_t new_in_range = (std::abs(new_price - best_price) <= 2000);
-
-    vol -= og_size * og_in_range;
-    vol += new_size * new_in_range;
-}
-
-std::string Orderbook::get_formatted_time_fast() const {
-    static thread_local char buffer[32];
-    static thread_local time_t last_second = 0;
-    static thread_local char last_second_str[20];
-
-    auto now = std::chrono::system_clock::to_time_t(current_message_time_);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            current_message_time_.time_since_epoch()) % 1000;
-
-    if (now != last_second) {
-        last_second = now;
-        struct tm tm_buf;
-        localtime_r(&now, &tm_buf);
-        strftime(last_second_str, sizeof(last_second_str), "%Y-%m-%d %H:%M:%S", &tm_buf);
+void Orderbook::copy_level_volumes(uint32_t* out, size_t levels) const {
+    size_t i = 0;
+    auto copy = [&](const auto& side) {
+        for (auto it = side.begin(); it != side.end() && i < levels; ++it, ++i) {
+            out[i] = static_cast<uint32_t>(it->second->volume_);
+        }
+    };
+    if constexpr (Side) {
+        copy(bids_);
+    } else {
+        copy(offers_);
     }
-
-    snprintf(buffer, sizeof(buffer), "%s.%03d", last_second_str, static_cast<int>(ms.count()));
-    return std::string(buffer);
+    std::fill(out + i, out + levels, 0u);
 }
 
+double Orderbook::weighted_imbalance(const double* weights, size_t levels) {
+    levels = std::min(levels, DEPTH_LEVELS);
+    copy_level_volumes<true>(bid_levels_.data(), levels);
+    copy_level_volumes<false>(ask_levels_.data(), levels);
 
-
-void Orderbook::calculate_skew() {
-    skew_ = log10(get_bid_depth()) - log10(get_ask_depth());
+    const DepthKernels& kernels = depth_kernels();
+    double bid = kernels.weighted_sum(bid_levels_.data(), weights, levels);
+    double ask = kernels.weighted_sum(ask_levels_.data(), weights, levels);
+    double total = bid + ask;
+    return total == 0.0 ? 0.0 : (bid - ask) / total;
 }
 
+size_t Orderbook::depth_imbalance(double* out, size_t levels) {
+    levels = std::min(levels, DEPTH_LEVELS);
+    copy_level_volumes<true>(bid_levels_.data(), levels);
+    copy_level_volumes<false>(ask_levels_.data(), levels);
 
-void Orderbook::calculate_imbalance() {
-    uint64_t total_vol = bid_vol_ + ask_vol_;
-    if (total_vol == 0) {
-        imbalance_ = 0.0;
-        return;
-    }
-    imbalance_ = static_cast<double>(static_cast<int64_t>(bid_vol_) - static_cast<int64_t>(ask_vol_)) / static_cast<double>(total_vol);
+    const DepthKernels& kernels = depth_kernels();
+    kernels.cumulative(bid_levels_.data(), bid_levels_.data(), levels);
+    kernels.cumulative(ask_levels_.data(), ask_levels_.data(), levels);
+    kernels.imbalance(bid_levels_.data(), ask_levels_.data(), out, levels);
+    return levels;
 }
 
 void Orderbook::reset() {
-    for (auto &pair: bids_) {
-        delete pair.second;
-    }
     bids_.clear();
-
-    for (auto &pair: offers_) {
-        delete pair.second;
-    }
     offers_.clear();
-
+    bid_top_.clear();
+    ask_top_.clear();
     order_lookup_.clear();
-    limit_lookup_.clear();
 
     order_pool_.reset();
+    limit_pool_.reset();
 
+    ct_ = 0;
     bid_count_ = 0;
     ask_count_ = 0;
-    update_possible = false;
     vwap_ = 0.0;
     sum1_ = 0.0;
     sum2_ = 0.0;
@@ -279,31 +353,190 @@ void Orderbook::reset() {
     ask_vol_ = 0;
     last_reset_time_ = "";
     imbalance_ = 0.0;
+    in_event_ = false;
+    bbo_ = Bbo{};
+    bbo_changed_ = true;
+    publish_bbo();
 
-    current_message_time_ = std::chrono::system_clock::time_point();
+    clock_.reset();
 
-    bids_.get_allocator().allocate(1000);
-    offers_.get_allocator().allocate(1000);
-    order_lookup_.reserve(1000000);
-    limit_lookup_.reserve(2000);
 }
 
-int32_t Orderbook::get_best_bid_price() const { return bids_.begin()->first; }
+void Orderbook::process_batch(const message* msgs, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (i + PREFETCH_SLOT_AHEAD < count) {
+            prefetch_slot(msgs[i + PREFETCH_SLOT_AHEAD]);
+        }
+        if (i + PREFETCH_ORDER_AHEAD < count) {
+            prefetch_order(msgs[i + PREFETCH_ORDER_AHEAD]);
+        }
+        if (i + PREFETCH_LIMIT_AHEAD < count) {
+            prefetch_limit(msgs[i + PREFETCH_LIMIT_AHEAD]);
+        }
+        process_msg(msgs[i]);
+    }
+}
 
-int32_t Orderbook::get_best_ask_price() const { return offers_.begin()->first; }
+// the prefetch stages only read. a message between here and the prefetched one may still
+// add, move or free what they point at, which costs a useless prefetch but never a wrong result
 
-uint64_t Orderbook::get_count() const { return bid_count_ + ask_count_; }
+void Orderbook::prefetch_slot(const message& msg) const {
+    if (msg.action_ == 'C' || msg.action_ == 'M') {
+        order_lookup_.prefetch(msg.id_);
+    }
+}
 
-uint64_t Orderbook::get_bid_depth() const { return bids_.begin()->second->volume_; }
+void Orderbook::prefetch_order(const message& msg) {
+    if (msg.action_ == 'C' || msg.action_ == 'M') {
+        auto it = order_lookup_.find(msg.id_);
+        if (it != order_lookup_.end()) {
+            __builtin_prefetch(order_pool_.at(it->second));
+            if (msg.action_ == 'M') {
+                __builtin_prefetch(&order_pool_.info(it->second));
+            }
+        }
+    } else if (msg.action_ == 'T') {
+        // trades walk the opposite side's queue at the trade price
+        auto prefetch_level = [&](auto& side) {
+            auto it = side.find(msg.price_);
+            if (it != side.end()) {
+                __builtin_prefetch(it->second);
+            }
+        };
+        msg.side_ ? prefetch_level(offers_) : prefetch_level(bids_);
+    }
+}
+
+void Orderbook::prefetch_limit(const message& msg) {
+    if (msg.action_ == 'C' || msg.action_ == 'M') {
+        auto it = order_lookup_.find(msg.id_);
+        if (it == order_lookup_.end()) {
+            return;
+        }
+        const Order* order = order_pool_.at(it->second);
+        if (order->parent_ != Order::NULL_ORDER) {
+            __builtin_prefetch(limit_pool_.at(order->parent_));
+        }
+        // unlinking writes both queue neighbours
+        if (order->prev_ != Order::NULL_ORDER) {
+            __builtin_prefetch(order_pool_.at(order->prev_));
+        }
+        if (order->next_ != Order::NULL_ORDER) {
+            __builtin_prefetch(order_pool_.at(order->next_));
+        }
+    } else if (msg.action_ == 'T') {
+        auto prefetch_head = [&](auto& side) {
+            auto it = side.find(msg.price_);
+            if (it != side.end() && it->second->head_ != Order::NULL_ORDER) {
+                __builtin_prefetch(order_pool_.at(it->second->head_));
+            }
+        };
+        msg.side_ ? prefetch_head(offers_) : prefetch_head(bids_);
+    }
+}
+
+bool Orderbook::save_checkpoint(const std::string& path, uint64_t message_index) const {
+    std::vector<CheckpointLevel> levels;
+    std::vector<CheckpointOrder> orders;
+    levels.reserve(bids_.size() + offers_.size());
+    orders.reserve(get_count());
+
+    auto collect = [&](const auto& side, bool is_bid) {
+        for (const auto& [price, limit]: side) {
+            CheckpointLevel level{};
+            level.price_ = price;
+            level.side_ = is_bid;
+            for (uint32_t handle = limit->head_; handle != Order::NULL_ORDER; handle = order_pool_.at(handle)->next_) {
+                const Order* order = order_pool_.at(handle);
+                const OrderInfo& info = order_pool_.info(handle);
+                CheckpointOrder record{};
+                record.id_ = info.id_;
+                record.unix_time_ = info.unix_time_;
+                record.size_ = order->size;
+                record.filled_ = order->filled_;
+                orders.push_back(record);
+                ++level.order_count_;
+            }
+            levels.push_back(level);
+        }
+    };
+    collect(bids_, true);
+    collect(offers_, false);
+
+    CheckpointHeader header{};
+    std::memcpy(header.magic_, CheckpointView::MAGIC, sizeof(header.magic_));
+    header.version_ = CheckpointView::VERSION;
+    header.level_count_ = static_cast<uint32_t>(levels.size());
+    header.order_count_ = orders.size();
+    header.message_index_ = message_index;
+    header.message_count_ = static_cast<uint64_t>(ct_);
+    header.last_time_ = clock_.now();
+    header.sum1_ = sum1_;
+    header.sum2_ = sum2_;
+    header.vwap_ = vwap_;
+
+    // written under a temporary name and renamed, so nobody maps a half written file
+    std::string tmp_path = path + ".tmp";
+    FILE* file = std::fopen(tmp_path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "error creating checkpoint: " << path << std::endl;
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(levels.data(), sizeof(CheckpointLevel), levels.size(), file) == levels.size() &&
+              std::fwrite(orders.data(), sizeof(CheckpointOrder), orders.size(), file) == orders.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        std::cerr << "error writing checkpoint: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Orderbook::load_checkpoint(const std::string& path, uint64_t* message_index) {
+    CheckpointView view(path);
+    if (!view.valid()) {
+        return false;
+    }
+    reset();
+
+    const CheckpointHeader& header = view.header();
+    const CheckpointOrder* record = view.orders();
+    for (uint32_t i = 0; i < header.level_count_; ++i) {
+        const CheckpointLevel& level = view.levels()[i];
+        // re-adding in saved order rebuilds each queue front to back
+        for (uint32_t j = 0; j < level.order_count_; ++j, ++record) {
+            uint32_t handle = level.side_
+                              ? create_order<true>(record->id_, level.price_, record->size_, record->unix_time_)
+                              : create_order<false>(record->id_, level.price_, record->size_, record->unix_time_);
+            order_pool_.at(handle)->filled_ = record->filled_ != 0;
+            order_lookup_.insert_or_assign(record->id_, handle);
+        }
+    }
+
+    ct_ = static_cast<int64_t>(header.message_count_);
+    sum1_ = header.sum1_;
+    sum2_ = header.sum2_;
+    vwap_ = header.vwap_;
+    clock_.advance(header.last_time_);
+    calculate_imbalance();
+    publish_bbo();
+    if (message_index) {
+        *message_index = header.message_index_;
+    }
+    return true;
+}
+
+uint64_t Orderbook::get_count() const { return bid_count_ + ask_count_; }
 
-uint64_t Orderbook::get_ask_depth() const { return offers_.begin()->second->volume_; }
 
 template void Orderbook::trade_order<true>(uint64_t, int32_t, uint32_t);
 template void Orderbook::trade_order<false>(uint64_t, int32_t, uint32_t);
 template void Orderbook::modify_order<true>(uint64_t, int32_t, uint32_t, uint64_t);
 template void Orderbook::modify_order<false>(uint64_t, int32_t, uint32_t, uint64_t);
-template void Orderbook::remove_order<true>(uint64_t, int32_t, uint32_t);
-template void Orderbook::remove_order<false>(uint64_t, int32_t, uint32_t);
+template void Orderbook::remove_order<true>(uint64_t);
+template void Orderbook::remove_order<false>(uint64_t);
 template void Orderbook::add_limit_order<true>(uint64_t, int32_t, uint32_t, uint64_t);
 template void Orderbook::add_limit_order<false>(uint64_t, int32_t, uint32_t, uint64_t);
 
@@ -313,11 +546,17 @@ template typename BookSide<false>::MapType& Orderbook::get_book_side<false>();
 template Limit* Orderbook::get_or_insert_limit<true>(int32_t);
 template Limit* Orderbook::get_or_insert_limit<false>(int32_t);
 
-template void Orderbook::update_vol<true>(int32_t, int32_t, bool);
-template void Orderbook::update_vol<false>(int32_t, int32_t, bool);
+template uint32_t Orderbook::create_order<true>(uint64_t, int32_t, uint32_t, uint64_t);
+template uint32_t Orderbook::create_order<false>(uint64_t, int32_t, uint32_t, uint64_t);
+
+template void Orderbook::erase_limit<true>(Limit*);
+template void Orderbook::erase_limit<false>(Limit*);
+
+template void Orderbook::copy_level_volumes<true>(uint32_t*, size_t) const;
+template void Orderbook::copy_level_volumes<false>(uint32_t*, size_t) const;
 
-template void Orderbook::update_modify_vol<true>(int32_t, int32_t, int32_t, int32_t);
-template void Orderbook::update_modify_vol<false>(int32_t, int32_t, int32_t, int32_t);
+template void Orderbook::sync_depth<true>();
+template void Orderbook::sync_depth<false>();
 
-template int32_t& Orderbook::get_volume<true>() ;
-template int32_t& Orderbook::get_volume<false>() ;
\ No newline at end of file
+template void Orderbook::update_bbo<true>(int32_t);
+template void Orderbook::update_bbo<false>(int32_t);
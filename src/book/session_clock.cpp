@@ -0,0 +1,362 @@
+#include "session_clock.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace {
+
+constexpr int64_t SECONDS_PER_DAY = 86400;
+
+int64_t floor_div(int64_t a, int64_t b) {
+    return a / b - (a % b != 0 && (a % b < 0) != (b < 0));
+}
+
+// days since 1970-01-01 of a proleptic gregorian date, month 1-12
+int64_t days_from_civil(int64_t y, int m, int d) {
+    y -= m <= 2;
+    const int64_t era = floor_div(y, 400);
+    const int64_t yoe = y - era * 400;
+    const int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+void civil_from_days(int64_t days, int64_t& y, int& m, int& d) {
+    days += 719468;
+    const int64_t era = floor_div(days, 146097);
+    const int64_t doe = days - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    d = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    m = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    y = yoe + era * 400 + (m <= 2);
+}
+
+int days_in_month(int64_t y, int m) {
+    return static_cast<int>(days_from_civil(m == 12 ? y + 1 : y, m == 12 ? 1 : m + 1, 1) - days_from_civil(y, m, 1));
+}
+
+uint64_t to_ns(int64_t seconds) {
+    return seconds > 0 ? static_cast<uint64_t>(seconds) * SessionClock::NS_PER_SECOND : 0;
+}
+
+// big endian fields of a tzif file
+int64_t read_be(const char* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) {
+        v = v << 8 | static_cast<unsigned char>(p[i]);
+    }
+    if (bytes < 8 && (v >> (bytes * 8 - 1))) {
+        v |= ~0ULL << (bytes * 8);
+    }
+    return static_cast<int64_t>(v);
+}
+
+}
+
+const ExchangeZone& ExchangeZone::cme() {
+    static const ExchangeZone zone(CME, CME_RULE);
+    return zone;
+}
+
+ExchangeZone::ExchangeZone(const std::string& name, const std::string& fallback_rule) : name_(name) {
+    const char* dir = std::getenv("TZDIR");
+    std::string path = !name.empty() && name[0] == '/' ? name
+                       : std::string(dir && *dir ? dir : "/usr/share/zoneinfo") + "/" + name;
+    valid_ = (!name.empty() && load_tzif(path)) || parse_rule(name);
+    if (!valid_ && !fallback_rule.empty()) {
+        transitions_.clear();
+        offsets_.clear();
+        valid_ = parse_rule(fallback_rule);
+        if (valid_) {
+            std::cerr << "no tzdata for " << name << ", using " << fallback_rule << std::endl;
+            return;
+        }
+    }
+    if (!valid_) {
+        std::cerr << "unknown time zone " << name << ", using utc" << std::endl;
+        initial_offset_ = 0;
+        transitions_.clear();
+        offsets_.clear();
+        rule_ = Rule();
+    }
+}
+
+bool ExchangeZone::load_tzif(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    constexpr size_t HEADER = 44;
+    struct Counts {
+        int64_t isut_, isstd_, leap_, time_, type_, chars_;
+    };
+    auto counts_at = [&](size_t at, Counts& counts) {
+        if (data.size() < at + HEADER || data.compare(at, 4, "TZif") != 0) {
+            return false;
+        }
+        const char* p = data.data() + at + 20;
+        counts = {read_be(p, 4), read_be(p + 4, 4), read_be(p + 8, 4), read_be(p + 12, 4), read_be(p + 16, 4),
+                  read_be(p + 20, 4)};
+        return counts.type_ > 0;
+    };
+
+    Counts counts;
+    if (!counts_at(0, counts)) {
+        return false;
+    }
+    // version 2+ repeats the data with 64 bit times and ends in the posix rule
+    size_t at = 0;
+    int time_bytes = 4;
+    const bool v2 = data[4] >= '2';
+    if (v2) {
+        at = HEADER + counts.time_ * 5 + counts.type_ * 6 + counts.chars_ + counts.leap_ * 8 + counts.isstd_ +
+             counts.isut_;
+        time_bytes = 8;
+        if (!counts_at(at, counts)) {
+            return false;
+        }
+    }
+    const size_t times = at + HEADER;
+    const size_t indices = times + counts.time_ * time_bytes;
+    const size_t types = indices + counts.time_;
+    const size_t end = types + counts.type_ * 6 + counts.chars_ + counts.leap_ * (time_bytes + 4) + counts.isstd_ +
+                       counts.isut_;
+    if (data.size() < end) {
+        return false;
+    }
+
+    auto offset_of = [&](int64_t type) {
+        return static_cast<int32_t>(read_be(data.data() + types + type * 6, 4));
+    };
+    transitions_.clear();
+    offsets_.clear();
+    for (int64_t i = 0; i < counts.time_; ++i) {
+        const auto type = static_cast<unsigned char>(data[indices + i]);
+        if (type >= counts.type_) {
+            return false;
+        }
+        transitions_.push_back(read_be(data.data() + times + i * time_bytes, time_bytes));
+        offsets_.push_back(offset_of(type));
+    }
+    initial_offset_ = offset_of(0);
+
+    // past the last transition the footer rule applies, or the last offset if there is none
+    rule_ = Rule();
+    rule_.std_offset_ = offsets_.empty() ? initial_offset_ : offsets_.back();
+    if (v2 && data.size() > end + 2 && data[end] == '\n') {
+        const size_t newline = data.find('\n', end + 1);
+        if (newline != std::string::npos && newline > end + 1) {
+            return parse_rule(data.substr(end + 1, newline - end - 1));
+        }
+    }
+    return true;
+}
+
+// std offset [dst [offset] [,start[/time],end[/time]]], e.g. CST6CDT,M3.2.0,M11.1.0. posix
+// offsets count hours west of utc
+bool ExchangeZone::parse_rule(const std::string& rule) {
+    size_t pos = 0;
+    auto name = [&]() {
+        const size_t begin = pos;
+        if (pos < rule.size() && rule[pos] == '<') {
+            pos = rule.find('>', pos);
+            if (pos == std::string::npos) {
+                return false;
+            }
+            ++pos;
+            return true;
+        }
+        while (pos < rule.size() && std::isalpha(static_cast<unsigned char>(rule[pos]))) {
+            ++pos;
+        }
+        return pos - begin >= 3;
+    };
+    auto number = [&](int32_t& value) {
+        if (pos >= rule.size() || !std::isdigit(static_cast<unsigned char>(rule[pos]))) {
+            return false;
+        }
+        value = 0;
+        while (pos < rule.size() && std::isdigit(static_cast<unsigned char>(rule[pos]))) {
+            value = value * 10 + (rule[pos++] - '0');
+        }
+        return true;
+    };
+    // [+-]hh[:mm[:ss]]
+    auto time = [&](int32_t& seconds) {
+        int32_t sign = 1;
+        if (pos < rule.size() && (rule[pos] == '+' || rule[pos] == '-')) {
+            sign = rule[pos++] == '-' ? -1 : 1;
+        }
+        int32_t part = 0;
+        if (!number(part)) {
+            return false;
+        }
+        seconds = part * 3600;
+        for (int32_t scale: {60, 1}) {
+            if (pos + 1 < rule.size() && rule[pos] == ':') {
+                ++pos;
+                if (!number(part)) {
+                    return false;
+                }
+                seconds += part * scale;
+            }
+        }
+        seconds *= sign;
+        return true;
+    };
+    // only the Mm.w.d form, which every current tzdata rule uses
+    auto change = [&](Change& c) {
+        if (pos >= rule.size() || rule[pos] != ',' || ++pos >= rule.size() || rule[pos++] != 'M') {
+            return false;
+        }
+        int32_t month = 0, week = 0, weekday = 0;
+        if (!number(month) || pos >= rule.size() || rule[pos++] != '.' || !number(week) || pos >= rule.size() ||
+            rule[pos++] != '.' || !number(weekday) || month < 1 || month > 12 || week < 1 || week > 5 ||
+            weekday > 6) {
+            return false;
+        }
+        c = Change{month, week, weekday, 7200};
+        if (pos < rule.size() && rule[pos] == '/') {
+            ++pos;
+            return time(c.time_);
+        }
+        return true;
+    };
+
+    Rule parsed;
+    int32_t west = 0;
+    if (!name() || !time(west)) {
+        return false;
+    }
+    parsed.std_offset_ = -west;
+    parsed.dst_offset_ = parsed.std_offset_;
+    if (pos < rule.size()) {
+        if (!name()) {
+            return false;
+        }
+        parsed.has_dst_ = true;
+        parsed.dst_offset_ = parsed.std_offset_ + 3600;
+        if (pos < rule.size() && rule[pos] != ',') {
+            if (!time(west)) {
+                return false;
+            }
+            parsed.dst_offset_ = -west;
+        }
+        // no dates given: the us rules, as glibc assumes
+        parsed.start_ = Change{3, 2, 0, 7200};
+        parsed.end_ = Change{11, 1, 0, 7200};
+        if (pos < rule.size() && (!change(parsed.start_) || !change(parsed.end_))) {
+            return false;
+        }
+    }
+    if (pos != rule.size()) {
+        return false;
+    }
+    rule_ = parsed;
+    return true;
+}
+
+int32_t ExchangeZone::rule_offset(int64_t utc_seconds) const {
+    if (!rule_.has_dst_) {
+        return rule_.std_offset_;
+    }
+    int64_t year;
+    int month, day;
+    civil_from_days(floor_div(utc_seconds + rule_.std_offset_, SECONDS_PER_DAY), year, month, day);
+    // local seconds of a change in `year`, the start is given in standard time and the end in dst
+    auto local = [year](const Change& c) {
+        const int64_t first = days_from_civil(year, c.month_, 1);
+        const int first_weekday = static_cast<int>(((first + 4) % 7 + 7) % 7);   // 1970-01-01 was a thursday
+        int mday = 1 + (c.weekday_ - first_weekday + 7) % 7 + (c.week_ - 1) * 7;
+        const int last = days_in_month(year, c.month_);
+        while (mday > last) {
+            mday -= 7;
+        }
+        return (first + mday - 1) * SECONDS_PER_DAY + c.time_;
+    };
+    const int64_t start = local(rule_.start_) - rule_.std_offset_;
+    const int64_t end = local(rule_.end_) - rule_.dst_offset_;
+    // southern zones are in dst across the new year
+    const bool dst = start < end ? utc_seconds >= start && utc_seconds < end
+                                 : utc_seconds >= start || utc_seconds < end;
+    return dst ? rule_.dst_offset_ : rule_.std_offset_;
+}
+
+int32_t ExchangeZone::utc_offset(int64_t utc_seconds) const {
+    auto next = std::upper_bound(transitions_.begin(), transitions_.end(), utc_seconds);
+    if (next == transitions_.end()) {
+        return rule_offset(utc_seconds);
+    }
+    return next == transitions_.begin() ? initial_offset_ : offsets_[next - transitions_.begin() - 1];
+}
+
+int64_t ExchangeZone::to_utc(int64_t local_seconds) const {
+    // offsets change at most once a day around any wall time
+    const int64_t first = local_seconds - utc_offset(local_seconds - SECONDS_PER_DAY);
+    const int64_t second = local_seconds - utc_offset(local_seconds + SECONDS_PER_DAY);
+    const bool first_ok = to_local(first) == local_seconds;
+    const bool second_ok = to_local(second) == local_seconds;
+    if (first_ok && second_ok) {
+        return std::min(first, second);
+    }
+    return second_ok ? second : first;
+}
+
+void SessionClock::roll(uint64_t ns) {
+    const int64_t local = zone_->to_local(static_cast<int64_t>(ns / NS_PER_SECOND));
+    const int64_t day = floor_div(local, SECONDS_PER_DAY) * SECONDS_PER_DAY;
+    midnight_ = to_ns(zone_->to_utc(day));
+    next_midnight_ = to_ns(zone_->to_utc(day + SECONDS_PER_DAY));
+}
+
+std::string SessionClock::format() const {
+    static thread_local char buffer[48];
+    static thread_local int64_t last_second = -1;
+    static thread_local const ExchangeZone* last_zone = nullptr;
+    static thread_local char last_second_str[32];
+
+    const auto now = static_cast<int64_t>(now_ / NS_PER_SECOND);
+    auto ms = static_cast<int>(now_ / NS_PER_MILLI % 1000);
+
+    if (now != last_second || zone_ != last_zone) {
+        last_second = now;
+        last_zone = zone_;
+        const int64_t local = zone_->to_local(now);
+        const int64_t days = floor_div(local, SECONDS_PER_DAY);
+        const int64_t second_of_day = local - days * SECONDS_PER_DAY;
+        int64_t year;
+        int month, day;
+        civil_from_days(days, year, month, day);
+        snprintf(last_second_str, sizeof(last_second_str), "%04lld-%02d-%02d %02d:%02d:%02d",
+                 static_cast<long long>(year), month, day, static_cast<int>(second_of_day / 3600),
+                 static_cast<int>(second_of_day / 60 % 60), static_cast<int>(second_of_day % 60));
+    }
+
+    snprintf(buffer, sizeof(buffer), "%s.%03d", last_second_str, ms);
+    return std::string(buffer);
+}
+
+uint64_t SessionClock::parse(const std::string& exchange_time, const ExchangeZone& zone) {
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0, ms = 0;
+    int fields = sscanf(exchange_time.c_str(), "%d-%d-%d %d:%d:%d.%d", &year, &month, &day, &hour, &minute,
+                        &second, &ms);
+    if (fields < 6 || month < 1 || month > 12) {
+        return 0;
+    }
+    // out of range days and times carry over like mktime's
+    const int64_t local = (days_from_civil(year, month, 1) + day - 1) * SECONDS_PER_DAY + hour * 3600 +
+                          minute * 60 + second;
+    const int64_t seconds = zone.to_utc(local);
+    if (seconds < 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(seconds) * NS_PER_SECOND + static_cast<uint64_t>(ms) * NS_PER_MILLI;
+}
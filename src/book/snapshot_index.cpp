@@ -0,0 +1,168 @@
+#include "snapshot_index.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+constexpr uint64_t NS_PER_SECOND = 1000000000ULL;
+
+std::string index_path(const std::string& dir) {
+    return dir + "/index.bin";
+}
+
+}
+
+std::string SnapshotIndex::snapshot_path(const std::string& dir, uint64_t message_index) {
+    return dir + "/snapshot_" + std::to_string(message_index) + ".ckpt";
+}
+
+bool SnapshotIndex::build(Orderbook& book, const std::vector<message>& messages, const std::string& dir,
+                          uint32_t interval_seconds) {
+    if (messages.empty() || interval_seconds == 0) {
+        std::cerr << "nothing to index" << std::endl;
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        std::cerr << "error creating snapshot directory: " << dir << std::endl;
+        return false;
+    }
+
+    const uint64_t interval = static_cast<uint64_t>(interval_seconds) * NS_PER_SECOND;
+    SnapshotIndexHeader header{};
+    std::memcpy(header.magic_, MAGIC, sizeof(header.magic_));
+    header.version_ = VERSION;
+    header.interval_seconds_ = interval_seconds;
+    header.message_count_ = messages.size();
+    header.last_time_ = messages.back().time_;
+    header.first_second_ = messages.front().time_ / NS_PER_SECOND * NS_PER_SECOND;
+
+    std::vector<uint64_t> second_offsets;
+    std::vector<SnapshotEntry> snapshots;
+    uint64_t next_second = header.first_second_;
+    // snapshots land on multiples of the interval, e.g. every round minute
+    uint64_t next_snapshot = (header.first_second_ / interval + 1) * interval;
+
+    book.reset();
+    for (size_t i = 0; i < messages.size(); ++i) {
+        uint64_t time = messages[i].time_;
+        while (next_second <= time) {
+            second_offsets.push_back(i);
+            next_second += NS_PER_SECOND;
+        }
+        // a snapshot never splits an exchange event, it waits for the next boundary instead
+        if (time >= next_snapshot && !book.in_event()) {
+            if (!book.save_checkpoint(snapshot_path(dir, i), i)) {
+                return false;
+            }
+            snapshots.push_back({time, i});
+            next_snapshot = (time / interval + 1) * interval;
+        }
+        book.process_msg(messages[i]);
+    }
+    header.second_count_ = second_offsets.size();
+    header.snapshot_count_ = snapshots.size();
+
+    std::string path = index_path(dir);
+    std::string tmp_path = path + ".tmp";
+    FILE* file = std::fopen(tmp_path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "error creating snapshot index: " << path << std::endl;
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(second_offsets.data(), sizeof(uint64_t), second_offsets.size(), file) == second_offsets.size() &&
+              std::fwrite(snapshots.data(), sizeof(SnapshotEntry), snapshots.size(), file) == snapshots.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        std::cerr << "error writing snapshot index: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+SnapshotIndex::SnapshotIndex(const std::string& dir) : dir_(dir) {
+    std::ifstream file(index_path(dir), std::ios::binary);
+    if (!file) {
+        return;
+    }
+    SnapshotIndexHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic_, MAGIC, sizeof(MAGIC)) != 0 || header.version_ != VERSION) {
+        std::cerr << "not a version " << VERSION << " snapshot index: " << index_path(dir) << std::endl;
+        return;
+    }
+
+    // one offset per second and one snapshot per interval at most, anything bigger is corrupt
+    const uint64_t max_entries = header.message_count_ + 1;
+    if (header.second_count_ > max_entries || header.snapshot_count_ > max_entries) {
+        std::cerr << "corrupt snapshot index: " << index_path(dir) << std::endl;
+        return;
+    }
+    second_offsets_.resize(header.second_count_);
+    snapshots_.resize(header.snapshot_count_);
+    if (!file.read(reinterpret_cast<char*>(second_offsets_.data()), second_offsets_.size() * sizeof(uint64_t)) ||
+        !file.read(reinterpret_cast<char*>(snapshots_.data()), snapshots_.size() * sizeof(SnapshotEntry))) {
+        std::cerr << "truncated snapshot index: " << index_path(dir) << std::endl;
+        second_offsets_.clear();
+        snapshots_.clear();
+        return;
+    }
+    header_ = header;
+    valid_ = true;
+}
+
+bool SnapshotIndex::matches(const std::vector<message>& messages) const {
+    return valid_ && messages.size() == header_.message_count_ && !messages.empty() &&
+           messages.back().time_ == header_.last_time_;
+}
+
+size_t SnapshotIndex::message_offset(const std::vector<message>& messages, uint64_t ts) const {
+    auto after = [](uint64_t time, const message& msg) { return time < msg.time_; };
+    if (!matches(messages) || second_offsets_.empty()) {
+        return std::upper_bound(messages.begin(), messages.end(), ts, after) - messages.begin();
+    }
+    if (ts < header_.first_second_) {
+        return 0;
+    }
+
+    // only the messages inside ts's second need searching
+    uint64_t second = (ts - header_.first_second_) / NS_PER_SECOND;
+    if (second >= second_offsets_.size()) {
+        second = second_offsets_.size() - 1;
+    }
+    size_t lo = second_offsets_[second];
+    size_t hi = second + 1 < second_offsets_.size() ? second_offsets_[second + 1] : messages.size();
+    return std::upper_bound(messages.begin() + lo, messages.begin() + hi, ts, after) - messages.begin();
+}
+
+size_t SnapshotIndex::book_at(Orderbook& book, const std::vector<message>& messages, uint64_t ts) const {
+    size_t end = message_offset(messages, ts);
+    size_t start = 0;
+
+    if (matches(messages)) {
+        // latest snapshot that does not pass `end`, stepping back if one fails to load
+        auto it = std::upper_bound(snapshots_.begin(), snapshots_.end(), end,
+                                   [](size_t index, const SnapshotEntry& entry) { return index < entry.message_index_; });
+        while (it != snapshots_.begin()) {
+            --it;
+            uint64_t index = 0;
+            if (book.load_checkpoint(snapshot_path(dir_, it->message_index_), &index) && index == it->message_index_) {
+                start = index;
+                break;
+            }
+        }
+    }
+
+    if (start == 0) {
+        book.reset();
+    }
+    book.process_batch(messages.data() + start, end - start);
+    return end;
+}
@@ -0,0 +1,132 @@
+#include <initializer_list>
+#include "csv_scan.h"
+
+#if !defined(ORDERBOOK_SIMD_SCALAR) && (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define ORDERBOOK_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+#if !defined(ORDERBOOK_SIMD_SCALAR) && defined(__ARM_NEON) && defined(__aarch64__)
+#define ORDERBOOK_NEON_KERNELS 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+uint64_t separators_scalar(const char *block, uint64_t &newlines) {
+    uint64_t commas = 0;
+    uint64_t lines = 0;
+    for (size_t i = 0; i < CSV_BLOCK; ++i) {
+        commas |= static_cast<uint64_t>(block[i] == ',') << i;
+        lines |= static_cast<uint64_t>(block[i] == '\n') << i;
+    }
+    newlines = lines;
+    return commas | lines;
+}
+
+const CsvScanKernels SCALAR_KERNELS = {SimdBackend::Scalar, "scalar", separators_scalar};
+
+#ifdef ORDERBOOK_X86_KERNELS
+
+__attribute__((target("sse4.2")))
+uint64_t separators_sse42(const char *block, uint64_t &newlines) {
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    uint64_t commas = 0;
+    uint64_t lines = 0;
+    for (size_t i = 0; i < CSV_BLOCK; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+        commas |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, comma)))) << i;
+        lines |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)))) << i;
+    }
+    newlines = lines;
+    return commas | lines;
+}
+
+__attribute__((target("avx2")))
+uint64_t separators_avx2(const char *block, uint64_t &newlines) {
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+    __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+    uint64_t commas = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, comma))) |
+                      static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, comma)))) << 32;
+    uint64_t lines = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, newline))) |
+                     static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, newline)))) << 32;
+    newlines = lines;
+    return commas | lines;
+}
+
+const CsvScanKernels SSE42_KERNELS = {SimdBackend::SSE42, "sse4.2", separators_sse42};
+const CsvScanKernels AVX2_KERNELS = {SimdBackend::AVX2, "avx2", separators_avx2};
+
+#endif
+
+#ifdef ORDERBOOK_NEON_KERNELS
+
+// neon has no movemask, weight each lane by its bit and add pairwise down to 64 bits
+inline uint64_t movemask_neon(uint8x16_t m0, uint8x16_t m1, uint8x16_t m2, uint8x16_t m3) {
+    const uint8x16_t bits = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t sum0 = vpaddq_u8(vandq_u8(m0, bits), vandq_u8(m1, bits));
+    uint8x16_t sum1 = vpaddq_u8(vandq_u8(m2, bits), vandq_u8(m3, bits));
+    sum0 = vpaddq_u8(sum0, sum1);
+    sum0 = vpaddq_u8(sum0, sum0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+uint64_t separators_neon(const char *block, uint64_t &newlines) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(block);
+    uint8x16_t c0 = vld1q_u8(bytes);
+    uint8x16_t c1 = vld1q_u8(bytes + 16);
+    uint8x16_t c2 = vld1q_u8(bytes + 32);
+    uint8x16_t c3 = vld1q_u8(bytes + 48);
+    const uint8x16_t comma = vdupq_n_u8(',');
+    const uint8x16_t newline = vdupq_n_u8('\n');
+    uint64_t commas = movemask_neon(vceqq_u8(c0, comma), vceqq_u8(c1, comma), vceqq_u8(c2, comma),
+                                    vceqq_u8(c3, comma));
+    uint64_t lines = movemask_neon(vceqq_u8(c0, newline), vceqq_u8(c1, newline), vceqq_u8(c2, newline),
+                                   vceqq_u8(c3, newline));
+    newlines = lines;
+    return commas | lines;
+}
+
+const CsvScanKernels NEON_KERNELS = {SimdBackend::NEON, "neon", separators_neon};
+
+#endif
+
+const CsvScanKernels &select_kernels() {
+    for (SimdBackend backend: {SimdBackend::AVX2, SimdBackend::NEON, SimdBackend::SSE42}) {
+        if (const CsvScanKernels *kernels = csv_scan_kernels_for(backend)) {
+            return *kernels;
+        }
+    }
+    return SCALAR_KERNELS;
+}
+
+}
+
+const CsvScanKernels *csv_scan_kernels_for(SimdBackend backend) {
+    switch (backend) {
+        case SimdBackend::Scalar:
+            return &SCALAR_KERNELS;
+#ifdef ORDERBOOK_X86_KERNELS
+        case SimdBackend::SSE42:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse4.2") ? &SSE42_KERNELS : nullptr;
+        case SimdBackend::AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") ? &AVX2_KERNELS : nullptr;
+#endif
+#ifdef ORDERBOOK_NEON_KERNELS
+        case SimdBackend::NEON:
+            return &NEON_KERNELS;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+const CsvScanKernels &csv_scan_kernels() {
+    static const CsvScanKernels &kernels = select_kernels();
+    return kernels;
+}
@@ -0,0 +1,136 @@
+#include "dbn.h"
+#include <algorithm>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "orderbook.h"
+
+DbnFile::DbnFile(const std::string& file_path, uint32_t instrument_id)
+        : file_path_(file_path), instrument_id_(instrument_id) {
+    int fd = open(file_path_.c_str(), O_RDONLY);
+    if (fd == -1) {
+        std::cerr << "error opening file: " << file_path_ << std::endl;
+        return;
+    }
+
+    struct stat sb;
+    if (fstat(fd, &sb) == -1) {
+        std::cerr << "error getting file size" << std::endl;
+        close(fd);
+        return;
+    }
+
+    file_size_ = sb.st_size;
+    void* mapped = file_size_ > 0 ? mmap(nullptr, file_size_, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "error mapping file: " << file_path_ << std::endl;
+        return;
+    }
+    mapped_file_ = static_cast<uint8_t*>(mapped);
+    madvise(mapped_file_, file_size_, MADV_SEQUENTIAL);
+
+    if (!read_metadata()) {
+        records_ = end_ = nullptr;
+    }
+}
+
+DbnFile::~DbnFile() {
+    if (mapped_file_) {
+        munmap(mapped_file_, file_size_);
+    }
+}
+
+bool DbnFile::read_metadata() {
+    const uint8_t* data = mapped_file_;
+    if (file_size_ >= 4 && dbn::load<uint32_t>(data) == 0xFD2FB528) {
+        std::cerr << file_path_ << " is zstd compressed, decompress it first (zstd -d)" << std::endl;
+        return false;
+    }
+    if (file_size_ < 8 || std::memcmp(data, "DBN", 3) != 0) {
+        std::cerr << file_path_ << " is not a dbn file" << std::endl;
+        return false;
+    }
+    version_ = data[3];
+    if (version_ < 1 || version_ > 3) {
+        std::cerr << "unsupported dbn version " << static_cast<int>(version_) << " in " << file_path_ << std::endl;
+        return false;
+    }
+
+    // dataset (16 chars) and schema open the metadata in every version, the rest is not needed
+    const size_t metadata_length = dbn::load<uint32_t>(data + 4);
+    if (metadata_length < 18 || metadata_length > file_size_ - 8) {
+        std::cerr << "truncated dbn metadata in " << file_path_ << std::endl;
+        return false;
+    }
+    const char* dataset = reinterpret_cast<const char*>(data + 8);
+    dataset_.assign(dataset, strnlen(dataset, 16));
+    schema_ = dbn::load<uint16_t>(data + 24);
+    if (schema_ != dbn::SCHEMA_MBO && schema_ != dbn::SCHEMA_MIXED) {
+        std::cerr << file_path_ << " holds schema " << schema_ << ", not mbo" << std::endl;
+        return false;
+    }
+
+    records_ = data + 8 + metadata_length;
+    end_ = data + file_size_;
+    return true;
+}
+
+void DbnFile::report_truncated(const uint8_t* position) const {
+    std::cerr << "truncated dbn record at byte " << (position - mapped_file_) << " of " << file_path_ << std::endl;
+}
+
+size_t DbnFile::replay(Orderbook& book, const DbnPriceScale& scale) const {
+    return for_each_mbo([&](const DbnMboView& mbo) {
+        book.process_msg(to_message(mbo, scale));
+    });
+}
+
+std::vector<message> DbnFile::to_messages(const DbnPriceScale& scale) const {
+    std::vector<message> messages;
+    if (!is_open()) {
+        return messages;
+    }
+    // an upper bound when the file is all mbo records, a mixed file only over-reserves
+    messages.reserve((end_ - records_) / dbn::MBO_BYTES);
+    for_each_mbo([&](const DbnMboView& mbo) {
+        messages.push_back(to_message(mbo, scale));
+    });
+    return messages;
+}
+
+DbnSource::DbnSource(const std::string& file_path, uint32_t instrument_id, const DbnPriceScale& scale)
+        : file_(file_path, instrument_id), scale_(scale), position_(file_.records_begin()), batch_(BATCH) {
+    clear_batch();
+}
+
+double DbnSource::progress() const {
+    if (exhausted() || file_.records_end() == file_.records_begin()) {
+        return 1.0;
+    }
+    return static_cast<double>(position_ - file_.records_begin()) / (file_.records_end() - file_.records_begin());
+}
+
+void DbnSource::rewind() {
+    position_ = file_.records_begin();
+    read_ = 0;
+    clear_batch();
+}
+
+bool DbnSource::refill() {
+    if (!is_open()) {
+        return false;
+    }
+    size_t count = 0;
+    position_ = file_.for_each_mbo(position_, BATCH, [&](const DbnMboView& mbo) {
+        batch_[count++] = to_message(mbo, scale_);
+    });
+    if (count == 0) {
+        return false;
+    }
+    set_batch(batch_.data(), count, read_);
+    read_ += count;
+    return true;
+}
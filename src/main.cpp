@@ -4,14 +4,16 @@
 #include <QObject>
 #include <QTime>
 #include "backtester.h"
-#include "parser.h"
+#include "message_cache.h"
+#include "message_source.h"
 #include "database.h"
 #include "orderbook.h"
 #include "book_gui.h"
-#include "strategies/linear_model_strat.cpp"
-#include <chrono>
+#include "linear_model_strat.h"
+#include <algorithm>
 #include <iostream>
 #include <memory>
+#include <thread>
 
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
@@ -21,18 +23,14 @@ int main(int argc, char *argv[]) {
                  << "[Main] Initializing backtester...";
 
         DatabaseManager db_manager("127.0.0.1", 9009);
-        auto parsing_start = std::chrono::high_resolution_clock::now();
-        auto parser = std::make_unique<Parser>("es0604.csv");
-        auto train_parser = std::make_unique<Parser>("es0603.csv");
-        qDebug() << QTime::currentTime().toString("hh:mm:ss.zzz")
-                 << "[Main] Parsing messages...";
-        parser->parse();
-        train_parser->parse();
-        auto parsing_end = std::chrono::high_resolution_clock::now();
-        auto parsing_duration = std::chrono::duration_cast<std::chrono::duration<double>>(parsing_end - parsing_start);
-
-        qDebug() << QTime::currentTime().toString("hh:mm:ss.zzz")
-                 << "[Main] Parsing completed in" << parsing_duration.count() << "seconds";
+        // both days are mapped from the message caches next to the csvs, only the first launch
+        // parses them (on every core) and writes the caches. a mapped day keeps random access,
+        // so the warm start restores its checkpoint
+        const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        MessageCache day("es0604.csv", threads);
+        MessageCache train_day("es0603.csv", threads);
+        VectorSource messages(day.messages());
+        VectorSource train_messages(train_day.messages());
 
         qDebug() << QTime::currentTime().toString("hh:mm:ss.zzz")
                  << "[Main] Setting up backtester and strategies...";
@@ -40,7 +38,7 @@ int main(int argc, char *argv[]) {
         BookGui *gui = new BookGui();
         gui->show();
 
-        Backtester *backtester = new Backtester(db_manager, parser->message_stream_, train_parser->message_stream_);
+        Backtester *backtester = new Backtester(db_manager, messages, train_messages);
 
         qDebug() << QTime::currentTime().toString("hh:mm:ss.zzz")
                  << "[Main] Backtester created on thread:" << QThread::currentThreadId();
@@ -0,0 +1,190 @@
+#include "message_cache.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "parser.h"
+
+namespace {
+
+struct SourceStamp {
+    bool exists_ = false;
+    uint64_t size_ = 0;
+    int64_t mtime_ = 0;
+};
+
+SourceStamp source_stamp(const std::string& csv_path) {
+    SourceStamp stamp;
+    std::error_code ec;
+    stamp.size_ = std::filesystem::file_size(csv_path, ec);
+    if (ec) {
+        return {};
+    }
+    auto mtime = std::filesystem::last_write_time(csv_path, ec);
+    if (ec) {
+        return {};
+    }
+    stamp.mtime_ = static_cast<int64_t>(mtime.time_since_epoch().count());
+    stamp.exists_ = true;
+    return stamp;
+}
+
+inline uint64_t mix(uint64_t h, uint64_t word) {
+    h = (h ^ word) * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 32);
+}
+
+}
+
+std::string MessageCache::cache_path(const std::string& csv_path) {
+    return csv_path + ".msgcache";
+}
+
+uint64_t MessageCache::checksum(const void* data, size_t bytes) {
+    const char* p = static_cast<const char*>(data);
+    uint64_t lanes[4] = {1, 2, 3, 4};
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        uint64_t words[4];
+        std::memcpy(words, p + i, sizeof(words));
+        lanes[0] = mix(lanes[0], words[0]);
+        lanes[1] = mix(lanes[1], words[1]);
+        lanes[2] = mix(lanes[2], words[2]);
+        lanes[3] = mix(lanes[3], words[3]);
+    }
+    uint64_t h = mix(mix(mix(mix(bytes, lanes[0]), lanes[1]), lanes[2]), lanes[3]);
+    for (; i < bytes; ++i) {
+        h = mix(h, static_cast<unsigned char>(p[i]));
+    }
+    return h;
+}
+
+bool MessageCache::write(const std::string& csv_path, MessageSpan messages, uint32_t instrument_id) {
+    SourceStamp stamp = source_stamp(csv_path);
+    MessageCacheHeader header{};
+    std::memcpy(header.magic_, MAGIC, sizeof(header.magic_));
+    header.version_ = VERSION;
+    header.record_size_ = sizeof(message);
+    header.message_count_ = messages.size();
+    header.source_size_ = stamp.size_;
+    header.source_mtime_ = stamp.mtime_;
+    header.checksum_ = checksum(messages.data(), messages.size() * sizeof(message));
+    header.instrument_id_ = instrument_id;
+
+    std::string path = cache_path(csv_path);
+    std::string tmp_path = path + ".tmp";
+    FILE* file = std::fopen(tmp_path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "error creating message cache: " << path << std::endl;
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(messages.data(), sizeof(message), messages.size(), file) == messages.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        std::cerr << "error writing message cache: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+MessageCache::MessageCache(const std::string& csv_path, size_t threads, uint32_t instrument_id)
+        : csv_path_(csv_path), instrument_id_(instrument_id) {
+    if (map()) {
+        hit_ = true;
+        return;
+    }
+
+    Parser parser(csv_path_, instrument_id_);
+    parser.parse(threads);
+    if (parser.message_stream_.empty()) {
+        return;
+    }
+    // mapping the file just written costs no io, its pages are still in the page cache
+    if (write(csv_path_, parser.message_stream_, instrument_id_) && map()) {
+        return;
+    }
+    parsed_ = std::move(parser.message_stream_);
+    messages_ = MessageSpan(parsed_);
+}
+
+MessageCache::~MessageCache() {
+    unmap();
+}
+
+bool MessageCache::map() {
+    const std::string path = cache_path(csv_path_);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat sb;
+    if (fstat(fd, &sb) == -1 || static_cast<size_t>(sb.st_size) < sizeof(MessageCacheHeader)) {
+        close(fd);
+        std::cerr << "truncated message cache: " << path << std::endl;
+        return false;
+    }
+
+    // the whole file is read right away, replay then never waits on a page fault
+    mapped_size_ = sb.st_size;
+#ifdef MAP_POPULATE
+    void* mapped = mmap(nullptr, mapped_size_, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+#else
+    void* mapped = mmap(nullptr, mapped_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+#endif
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        mapped_size_ = 0;
+        std::cerr << "error mapping message cache: " << path << std::endl;
+        return false;
+    }
+    mapped_ = mapped;
+#ifndef MAP_POPULATE
+    madvise(mapped_, mapped_size_, MADV_WILLNEED);
+#endif
+
+    const auto* header = static_cast<const MessageCacheHeader*>(mapped_);
+    if (std::memcmp(header->magic_, MAGIC, sizeof(MAGIC)) != 0 || header->version_ != VERSION ||
+        header->record_size_ != sizeof(message)) {
+        std::cerr << "not a version " << VERSION << " message cache: " << path << std::endl;
+        unmap();
+        return false;
+    }
+    const size_t record_bytes = mapped_size_ - sizeof(MessageCacheHeader);
+    if (record_bytes % sizeof(message) != 0 || record_bytes / sizeof(message) != header->message_count_) {
+        std::cerr << "truncated message cache: " << path << std::endl;
+        unmap();
+        return false;
+    }
+    SourceStamp stamp = source_stamp(csv_path_);
+    if (header->instrument_id_ != instrument_id_ ||
+        (stamp.exists_ && (stamp.size_ != header->source_size_ || stamp.mtime_ != header->source_mtime_))) {
+        std::cerr << "stale message cache: " << path << std::endl;
+        unmap();
+        return false;
+    }
+
+    const auto* first = reinterpret_cast<const message*>(static_cast<const char*>(mapped_) + sizeof(MessageCacheHeader));
+    if (checksum(first, record_bytes) != header->checksum_) {
+        std::cerr << "corrupt message cache: " << path << std::endl;
+        unmap();
+        return false;
+    }
+    messages_ = MessageSpan(first, header->message_count_);
+    return true;
+}
+
+void MessageCache::unmap() {
+    if (mapped_) {
+        munmap(mapped_, mapped_size_);
+    }
+    mapped_ = nullptr;
+    mapped_size_ = 0;
+    messages_ = MessageSpan();
+}
@@ -0,0 +1,188 @@
+#include "message_source.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+CsvStreamSource::CsvStreamSource(const std::string& file_path, uint32_t instrument_id)
+        : file_path_(file_path), parser_(file_path, instrument_id), batches_(RING_BATCHES) {
+    fd_ = open(file_path_.c_str(), O_RDONLY);
+    if (fd_ == -1) {
+        std::cerr << "error opening file: " << file_path_ << std::endl;
+        return;
+    }
+    struct stat sb;
+    if (fstat(fd_, &sb) == 0) {
+        file_size_ = sb.st_size;
+    }
+    start();
+}
+
+CsvStreamSource::~CsvStreamSource() {
+    halt();
+    if (fd_ != -1) {
+        close(fd_);
+    }
+}
+
+double CsvStreamSource::progress() const {
+    if (exhausted() || file_size_ == 0) {
+        return exhausted() ? 1.0 : 0.0;
+    }
+    // a newline added after an unterminated last line counts one byte past the end
+    return std::min(1.0, static_cast<double>(consumed_bytes_) / file_size_);
+}
+
+void CsvStreamSource::rewind() {
+    halt();
+    clear_batch();
+    if (fd_ == -1) {
+        return;
+    }
+    lseek(fd_, 0, SEEK_SET);
+    start();
+}
+
+void CsvStreamSource::start() {
+    consumed_bytes_ = 0;
+    consumed_messages_ = 0;
+    current_ = nullptr;
+    filled_ = std::make_unique<BatchQueue>();
+    free_ = std::make_unique<BatchQueue>();
+    for (Batch& batch: batches_) {
+        free_->enqueue(&batch);
+    }
+    stop_ = false;
+    producer_ = std::thread(&CsvStreamSource::produce, this);
+}
+
+void CsvStreamSource::halt() {
+    stop_ = true;
+    if (producer_.joinable()) {
+        producer_.join();
+    }
+    current_ = nullptr;
+}
+
+bool CsvStreamSource::refill() {
+    if (fd_ == -1) {
+        return false;
+    }
+    if (current_) {
+        free_->enqueue(current_);
+        current_ = nullptr;
+    }
+    while (true) {
+        std::optional<Batch*> item = filled_->dequeue();
+        if (!item) {
+            std::this_thread::yield();
+            continue;
+        }
+        Batch* batch = *item;
+        if (!batch) {
+            // MessageSource does not ask again until rewind()
+            return false;
+        }
+        consumed_bytes_ = batch->file_offset_;
+        if (batch->count_ == 0) {
+            free_->enqueue(batch);
+            continue;
+        }
+        current_ = batch;
+        set_batch(batch->messages_.data(), batch->count_, consumed_messages_);
+        consumed_messages_ += batch->count_;
+        return true;
+    }
+}
+
+void CsvStreamSource::produce() {
+    // one spare byte for a missing final newline and CSV_PADDING behind it for the tokenizer
+    std::vector<char> buffer(CHUNK_BYTES + CSV_PADDING + 1);
+    size_t filled = 0;
+    size_t header_lines = Parser::HEADER_LINES;
+    uint64_t file_offset = 0;
+    size_t malformed = 0;
+    bool eof = false;
+
+    while (!stop_) {
+        const size_t capacity = buffer.size() - CSV_PADDING - 1;
+        while (!eof && filled < capacity) {
+            ssize_t n = read(fd_, buffer.data() + filled, capacity - filled);
+            if (n <= 0) {
+                if (n < 0) {
+                    std::cerr << "error reading " << file_path_ << std::endl;
+                }
+                eof = true;
+                break;
+            }
+            filled += n;
+        }
+
+        char* data = buffer.data();
+        size_t skip = 0;
+        while (header_lines > 0 && skip < filled) {
+            const char* newline = static_cast<const char*>(memchr(data + skip, '\n', filled - skip));
+            if (!newline) break;
+            skip = newline + 1 - data;
+            --header_lines;
+        }
+        if (skip > 0) {
+            std::memmove(data, data + skip, filled - skip);
+            filled -= skip;
+            file_offset += skip;
+        }
+        if (eof && filled > 0 && data[filled - 1] != '\n') {
+            data[filled++] = '\n';
+        }
+
+        // whole lines only, a partial last one waits for the next read
+        size_t lines = filled;
+        while (lines > 0 && data[lines - 1] != '\n') {
+            --lines;
+        }
+        if (header_lines > 0 || lines == 0) {
+            if (eof) {
+                break;
+            }
+            // a line longer than the whole buffer
+            if (filled == capacity) {
+                buffer.resize(buffer.size() * 2);
+            }
+            continue;
+        }
+
+        Batch* batch = nullptr;
+        while (!stop_) {
+            std::optional<Batch*> item = free_->dequeue();
+            if (item) {
+                batch = *item;
+                break;
+            }
+            std::this_thread::yield();
+        }
+        if (!batch) {
+            break;
+        }
+
+        batch->messages_.resize(Parser::count_lines(data, data + lines));
+        batch->count_ = parser_.parse_range(data, data + lines, batch->messages_.data(), malformed);
+        file_offset += lines;
+        batch->file_offset_ = file_offset;
+        filled_->enqueue(batch);
+
+        std::memmove(data, data + lines, filled - lines);
+        filled -= lines;
+        if (eof && filled == 0) {
+            break;
+        }
+    }
+
+    if (!stop_) {
+        filled_->enqueue(nullptr);
+    }
+    if (malformed > 0) {
+        std::cerr << "skipped " << malformed << " malformed lines in " << file_path_ << std::endl;
+    }
+}
@@ -0,0 +1,191 @@
+#include "param_sweep.h"
+#include "backtest_engine.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// one deque of grid indices per worker. a worker takes from the back of its own deque and,
+// once that is empty, steals from the front of the others starting with its neighbour.
+// nothing is pushed after the workers start, so all deques empty means the grid is done
+class StealingQueues {
+public:
+    explicit StealingQueues(size_t workers) : count_(workers), queues_(new Queue[workers]) {}
+
+    void push(size_t worker, size_t item) {
+        std::lock_guard<std::mutex> lock(queues_[worker].mutex_);
+        queues_[worker].items_.push_back(item);
+    }
+
+    bool pop(size_t worker, size_t &item) {
+        {
+            Queue &own = queues_[worker];
+            std::lock_guard<std::mutex> lock(own.mutex_);
+            if (!own.items_.empty()) {
+                item = own.items_.back();
+                own.items_.pop_back();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < count_; ++i) {
+            Queue &victim = queues_[(worker + i) % count_];
+            std::lock_guard<std::mutex> lock(victim.mutex_);
+            if (!victim.items_.empty()) {
+                item = victim.items_.front();
+                victim.items_.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct alignas(64) Queue {
+        std::mutex mutex_;
+        std::deque<size_t> items_;
+    };
+
+    size_t count_;
+    std::unique_ptr<Queue[]> queues_;
+};
+
+}
+
+std::vector<SweepPoint> linear_model_grid(const std::vector<int> &max_lags, const std::vector<int> &forecast_windows,
+                                          const std::vector<double> &thresholds) {
+    std::vector<SweepPoint> grid;
+    for (int max_lag: max_lags) {
+        for (int forecast_window: forecast_windows) {
+            for (double threshold: thresholds) {
+                SweepPoint point{};
+                point.strategy_ = SweepStrategy::LinearModel;
+                point.linear_.max_lag_ = max_lag;
+                point.linear_.forecast_window_ = forecast_window;
+                point.linear_.threshold_ = threshold;
+                grid.push_back(point);
+            }
+        }
+    }
+    return grid;
+}
+
+std::vector<SweepPoint> imbalance_grid(const std::vector<size_t> &depths, const std::vector<double> &thresholds) {
+    std::vector<SweepPoint> grid;
+    for (size_t depth: depths) {
+        for (double threshold: thresholds) {
+            SweepPoint point{};
+            point.strategy_ = SweepStrategy::Imbalance;
+            point.imbalance_.depth_ = depth;
+            point.imbalance_.threshold_ = threshold;
+            grid.push_back(point);
+        }
+    }
+    return grid;
+}
+
+ParameterSweep::ParameterSweep(DatabaseManager &db_manager, MessageSpan messages, MessageSpan train_messages)
+        : db_manager_(db_manager), messages_(messages), train_messages_(train_messages) {}
+
+void ParameterSweep::set_session(const std::string &start_time, const std::string &end_time) {
+    start_time_ = start_time;
+    end_time_ = end_time;
+}
+
+void ParameterSweep::set_train_session(const std::string &start_time, const std::string &end_time) {
+    train_start_time_ = start_time;
+    train_end_time_ = end_time;
+}
+
+SweepResult ParameterSweep::run_point(const SweepPoint &point, uint32_t worker) const {
+    auto start = std::chrono::steady_clock::now();
+
+    BacktestEngine engine(db_manager_, messages_, train_messages_);
+    engine.set_session(start_time_, end_time_);
+    engine.set_db_snapshots(false);
+    Orderbook &book = engine.book();
+
+    // strategies run quietly, a log file per point would be hundreds of files and threads
+    if (point.strategy_ == SweepStrategy::LinearModel) {
+        auto strategy = std::make_unique<LinearModelStrategy>(db_manager_, &book, point.linear_, "");
+        book.voi_history_ = voi_history_;
+        book.mid_prices_ = mid_prices_;
+        strategy->fit_model();
+        engine.add_strategy(std::move(strategy));
+    } else {
+        engine.add_strategy(std::make_unique<ImbalanceStrat>(db_manager_, &book, point.imbalance_, ""));
+    }
+
+    BacktestStats stats = engine.run();
+    const Strategy &strategy = *engine.strategies().front();
+    return SweepResult{point, strategy.get_pnl(), strategy.get_position(), strategy.get_trade_count(),
+                       stats.messages_, seconds_since(start), worker};
+}
+
+std::vector<SweepResult> ParameterSweep::run(const std::vector<SweepPoint> &grid, size_t threads) {
+    std::vector<SweepResult> results(grid.size());
+    if (grid.empty()) {
+        return results;
+    }
+    threads = std::clamp<size_t>(threads, 1, grid.size());
+
+    // shared state is built here, serially, and only read by the workers
+    bool fits_model = std::any_of(grid.begin(), grid.end(), [](const SweepPoint &point) {
+        return point.strategy_ == SweepStrategy::LinearModel;
+    });
+    if (fits_model) {
+        Orderbook train_book(db_manager_);
+        BacktestEngine::sample_session(train_book, train_messages_, train_start_time_, train_end_time_);
+        voi_history_ = std::move(train_book.voi_history_);
+        mid_prices_ = std::move(train_book.mid_prices_);
+    }
+    {
+        // leaves the session-open checkpoint on disk, workers then only ever load it
+        Orderbook book(db_manager_);
+        BacktestEngine::warm_start(book, messages_, start_time_, "backtest");
+    }
+
+    StealingQueues queues(threads);
+    for (size_t i = 0; i < grid.size(); ++i) {
+        queues.push(i % threads, i);
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t w = 0; w < threads; ++w) {
+        workers.emplace_back([this, &queues, &grid, &results, w]() {
+            size_t item;
+            while (queues.pop(w, item)) {
+                results[item] = run_point(grid[item], static_cast<uint32_t>(w));
+            }
+        });
+    }
+    for (auto &worker: workers) {
+        worker.join();
+    }
+    return results;
+}
+
+void ParameterSweep::print_table(const std::vector<SweepResult> &results, FILE *out) {
+    std::fprintf(out, "%-10s %5s %7s %6s %9s %10s %4s %7s %8s %6s\n", "strategy", "lag", "window", "depth",
+                 "threshold", "pnl", "pos", "trades", "seconds", "worker");
+    for (const SweepResult &result: results) {
+        const SweepPoint &point = result.point_;
+        if (point.strategy_ == SweepStrategy::LinearModel) {
+            std::fprintf(out, "%-10s %5d %7d %6s %9.3f", "linear", point.linear_.max_lag_,
+                         point.linear_.forecast_window_, "-", point.linear_.threshold_);
+        } else {
+            std::fprintf(out, "%-10s %5s %7s %6zu %9.3f", "imbalance", "-", "-", point.imbalance_.depth_,
+                         point.imbalance_.threshold_);
+        }
+        std::fprintf(out, " %10d %4d %7d %8.3f %6u\n", result.pnl_, result.position_, result.trades_,
+                     result.seconds_, result.worker_);
+    }
+}
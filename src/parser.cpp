@@ -1,10 +1,12 @@
 #include "parser.h"
+#include <algorithm>
 #include <cstring>
 #include <cstdlib>
+#include <thread>
 
-Parser::Parser(const std::string &file_path) : file_path_(file_path), mapped_file_(nullptr), file_size_(0) {
-    message_stream_.reserve(9000000);
-}
+Parser::Parser(const std::string &file_path, uint32_t instrument_id)
+        : file_path_(file_path), instrument_id_(instrument_id), mapped_file_(nullptr), file_size_(0),
+          kernels_(&csv_scan_kernels()) {}
 
 Parser::~Parser() {
     if (mapped_file_) {
@@ -12,7 +14,7 @@ Parser::~Parser() {
     }
 }
 
-void Parser::parse() {
+void Parser::parse(size_t threads) {
     int fd = open(file_path_.c_str(), O_RDONLY);
     if (fd == -1) {
         std::cerr << "error opening file: " << file_path_ << std::endl;
@@ -31,73 +33,193 @@ void Parser::parse() {
     close(fd);
 
     if (mapped_file_ == MAP_FAILED) {
+        mapped_file_ = nullptr;
         std::cerr << "error mapping file" << std::endl;
         return;
     }
 
-    parse_mapped_data();
+    parse_mapped_data(threads);
 }
 
-void Parser::parse_mapped_data() {
-    char* current = mapped_file_;
-    char* end = mapped_file_ + file_size_;
+void Parser::parse_mapped_data(size_t threads) {
+    const char* current = mapped_file_;
+    const char* end = mapped_file_ + file_size_;
 
-    for (int i = 0; i < 2 && current < end; ++i) {
-        current = static_cast<char*>(memchr(current, '\n', end - current));
+    for (size_t i = 0; i < HEADER_LINES && current < end; ++i) {
+        current = static_cast<const char*>(memchr(current, '\n', end - current));
         if (current) ++current;
-        else break;
+        else return;
     }
 
-    while (current < end) {
-        char* line_end = static_cast<char*>(memchr(current, '\n', end - current));
-        if (!line_end) line_end = end;
+    // the tokenizer reads up to CSV_PADDING bytes past what it parses. lines that end at least
+    // that far from the end of the mapping are parsed in place, the rest is copied into a padded
+    // buffer with its final newline added if the file lacks one
+    const char* body_end = current;
+    if (static_cast<size_t>(end - current) > CSV_PADDING) {
+        for (const char* p = end - CSV_PADDING - 1; p >= current; --p) {
+            if (*p == '\n') {
+                body_end = p + 1;
+                break;
+            }
+        }
+    }
+    std::vector<char> tail;
+    if (body_end < end) {
+        tail.assign(body_end, end);
+        if (tail.back() != '\n') {
+            tail.push_back('\n');
+        }
+    }
+    size_t tail_size = tail.size();
+    tail.resize(tail_size + CSV_PADDING, '\0');
+
+    // pieces end on a newline, the padded tail is always the last one
+    threads = std::max<size_t>(threads, 1);
+    std::vector<const char*> bounds{current};
+    for (size_t k = 1; k < threads; ++k) {
+        const char* cut = current + (body_end - current) * k / threads;
+        cut = std::max(cut, bounds.back());
+        const char* newline = cut < body_end ? static_cast<const char*>(memchr(cut, '\n', body_end - cut)) : nullptr;
+        bounds.push_back(newline ? newline + 1 : body_end);
+    }
+    bounds.push_back(body_end);
+    const size_t pieces = bounds.size();   // body chunks plus the tail
+    auto piece_range = [&](size_t k) {
+        using Range = std::pair<const char*, const char*>;
+        return k + 1 < pieces ? Range(bounds[k], bounds[k + 1]) : Range(tail.data(), tail.data() + tail_size);
+    };
+
+    // piece k runs on worker k % workers, worker 0 being this thread
+    const size_t workers = std::min(threads, pieces);
+    auto for_each_piece = [&](auto&& work) {
+        std::vector<std::thread> pool;
+        for (size_t w = 1; w < workers; ++w) {
+            pool.emplace_back([&, w]() {
+                for (size_t k = w; k < pieces; k += workers) work(k);
+            });
+        }
+        for (size_t k = 0; k < pieces; k += workers) work(k);
+        for (auto& thread: pool) {
+            thread.join();
+        }
+    };
+
+    // every line yields at most one message, so counting newlines sizes each slice exactly
+    // (malformed lines aside). message() leaves the fields alone, so the resize does not touch
+    // the pages and each worker faults in its own slice
+    std::vector<size_t> offsets(pieces + 1, 0);
+    std::vector<size_t> written(pieces, 0);
+    std::vector<size_t> malformed(pieces, 0);
+    for_each_piece([&](size_t k) {
+        auto range = piece_range(k);
+        offsets[k + 1] = count_lines(range.first, range.second);
+    });
+    for (size_t k = 0; k < pieces; ++k) {
+        offsets[k + 1] += offsets[k];
+    }
 
-        parse_line(current, line_end);
+    const size_t base = message_stream_.size();
+    message_stream_.resize(base + offsets[pieces]);
+    message* out = message_stream_.data() + base;
+    for_each_piece([&](size_t k) {
+        auto range = piece_range(k);
+        written[k] = parse_range(range.first, range.second, out + offsets[k], malformed[k]);
+    });
+
+    // slices are already in file order, they only move if a malformed line left a gap
+    size_t total = 0;
+    size_t skipped = 0;
+    for (size_t k = 0; k < pieces; ++k) {
+        if (total != offsets[k]) {
+            std::memmove(out + total, out + offsets[k], written[k] * sizeof(message));
+        }
+        total += written[k];
+        skipped += malformed[k];
+    }
+    message_stream_.resize(base + total);
 
-        current = line_end + 1;
+    if (skipped > 0) {
+        std::cerr << "skipped " << skipped << " malformed lines in " << file_path_ << std::endl;
     }
 }
 
-void Parser::parse_line(const char* start, const char* end) {
-    uint64_t ts_event, order_id;
-    int32_t price;
-    uint32_t size;
-    char action, side;
-
-    const char* token_start = start;
-    const char* token_end;
-
-    token_end = strchr(token_start, ',');
-    ts_event = strtoull(token_start, nullptr, 10);
-    //std::cout << "ts_event: " << ts_event << std::endl;
-    token_start = token_end + 1;
-
-    action = *token_start;
-    //std::cout << "action: " << action << std::endl;
-    token_start = strchr(token_start, ',') + 1;
-
-    side = *token_start;
-    //std::cout << "side: " << side << std::endl;
-    token_start = strchr(token_start, ',') + 1;
+// libc memchr is vectorised everywhere, so sizing costs the same whichever scan backend is used
+size_t Parser::count_lines(const char* begin, const char* end) {
+    size_t lines = 0;
+    while (begin < end) {
+        const char* newline = static_cast<const char*>(memchr(begin, '\n', end - begin));
+        if (!newline) break;
+        ++lines;
+        begin = newline + 1;
+    }
+    return lines;
+}
 
-    token_end = strchr(token_start, ',');
-    price = strtol(token_start, nullptr, 10);
-    //std::cout << "price: " << price << std::endl;
-    token_start = token_end + 1;
+size_t Parser::parse_range(const char* begin, const char* end, message* out, size_t& malformed) const {
+    const char* commas[MAX_COMMAS];
+    size_t count = 0;
+    size_t written = 0;
+    const char* line = begin;
+
+    for (const char* block = begin; block < end; block += CSV_BLOCK) {
+        uint64_t newlines;
+        uint64_t separators = kernels_->separators(block, newlines);
+        size_t remaining = end - block;
+        if (remaining < CSV_BLOCK) {
+            separators &= (1ULL << remaining) - 1;
+        }
+        while (separators) {
+            unsigned bit = __builtin_ctzll(separators);
+            const char* position = block + bit;
+            if ((newlines >> bit) & 1) {
+                if (parse_line(line, commas, count, position, out[written])) {
+                    ++written;
+                } else if (position > line && !(position == line + 1 && *line == '\r')) {
+                    ++malformed;
+                }
+                line = position + 1;
+                count = 0;
+            } else if (count < MAX_COMMAS) {
+                commas[count++] = position;
+            }
+            separators &= separators - 1;
+        }
+    }
+    return written;
+}
 
-    token_end = strchr(token_start, ',');
-    size = strtoul(token_start, nullptr, 10);
-    //std::cout << "size: " << size << std::endl;
-    token_start = token_end + 1;
+bool Parser::parse_line(const char* start, const char* const* commas, size_t count, const char* end,
+                        message& out) const {
+    if (end > start && end[-1] == '\r') {
+        --end;
+    }
+    // ts_event,action,side,price,size,order_id at least
+    if (count < 5) {
+        return false;
+    }
 
-    order_id = strtoull(token_start, nullptr, 10);
-    //std::cout << "order_id: " << order_id << std::endl;
+    uint64_t ts_event = csv::parse_uint(start, commas[0] - start);
+    char action = commas[0][1];
+    char side = commas[1][1];
+    int32_t price = static_cast<int32_t>(csv::parse_int(commas[2] + 1, commas[3] - commas[2] - 1));
+    uint32_t size = static_cast<uint32_t>(csv::parse_uint(commas[3] + 1, commas[4] - commas[3] - 1));
+    const char* order_id_end = count > 5 ? commas[5] : end;
+    uint64_t order_id = csv::parse_uint(commas[4] + 1, order_id_end - commas[4] - 1);
+
+    // flags,ts_in_delta,sequence follow order_id. older exports stop at order_id, their
+    // messages are each treated as a whole event
+    uint8_t flags = message::F_LAST;
+    uint32_t sequence = 0;
+    if (count > 5) {
+        const char* flags_end = count > 6 ? commas[6] : end;
+        flags = static_cast<uint8_t>(csv::parse_uint(commas[5] + 1, flags_end - commas[5] - 1));
+        if (count > 7) {
+            const char* sequence_end = count > 8 ? commas[8] : end;
+            sequence = static_cast<uint32_t>(csv::parse_uint(commas[7] + 1, sequence_end - commas[7] - 1));
+        }
+    }
 
     bool bid_or_ask = (side == 'B');
-    message msg(order_id, ts_event, size, price, action, bid_or_ask);
-    message_stream_.push_back(msg);
-
-    //std::cout << "-------------------------" << std::endl;
+    out = message(order_id, ts_event, size, price, action, bid_or_ask, instrument_id_, flags, sequence);
+    return true;
 }
-
-
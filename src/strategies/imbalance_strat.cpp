@@ -1,93 +1,85 @@
-#pragma once
-
-#include "strategy.h"
-
-class ImbalanceStrat : public Strategy {
-private:
-    double imbalance_mean_ = 0.0;
-    double imbalance_variance_ = 0.0;
-    int update_count_ = 0;
-    const int WARMUP_PERIOD = 1000;
-
-protected:
-    bool req_fitting = false;
-
-    void fit_model() override {
-
-    }
-
-
-
-
-    void update_theo_values() override {
-        if (position_ == 0) {
-            theo_total_buy_px_ = theo_total_sell_px_ = 0;
-        } else if (position_ > 0) {
-            theo_total_sell_px_ = book_->get_best_bid_price() * std::abs(position_);
-            theo_total_buy_px_ = 0;
-        } else {
-            theo_total_buy_px_ = book_->get_best_ask_price() * std::abs(position_);
-            theo_total_sell_px_ = 0;
-        }
+#include "imbalance_strat.h"
+#include <algorithm>
+#include <cmath>
+
+ImbalanceStrat::ImbalanceStrat(DatabaseManager &db_manager, Orderbook *book, const ImbalanceParams &params,
+                               const std::string &log_file_name)
+        : Strategy(db_manager, log_file_name, book), params_(params) {
+    params_.depth_ = std::clamp<size_t>(params_.depth_, 1, Orderbook::DEPTH_LEVELS);
+    depth_imbalance_.resize(params_.depth_);
+}
+
+double ImbalanceStrat::imbalance() {
+    // imbalance_ already covers the full window, shallower ones are summed on demand
+    if (params_.depth_ == Orderbook::DEPTH_LEVELS) {
+        return book_->imbalance_;
     }
-
-    void calculate_pnl() override {
-        pnl_ = POINT_VALUE_ * (real_total_sell_px_ + theo_total_sell_px_ -
-                               real_total_buy_px_ - theo_total_buy_px_) - fees_;
+    size_t levels = book_->depth_imbalance(depth_imbalance_.data(), params_.depth_);
+    return levels == 0 ? 0.0 : depth_imbalance_[levels - 1];
+}
+
+void ImbalanceStrat::update_theo_values() {
+    if (position_ == 0) {
+        theo_total_buy_px_ = theo_total_sell_px_ = 0;
+    } else if (position_ > 0) {
+        theo_total_sell_px_ = book_->get_best_bid_price() * std::abs(position_);
+        theo_total_buy_px_ = 0;
+    } else {
+        theo_total_buy_px_ = book_->get_best_ask_price() * std::abs(position_);
+        theo_total_sell_px_ = 0;
     }
+}
 
+void ImbalanceStrat::calculate_pnl() {
+    pnl_ = POINT_VALUE_ * (real_total_sell_px_ + theo_total_sell_px_ -
+                           real_total_buy_px_ - theo_total_buy_px_) - fees_;
+}
 
-    void log_stats(const Orderbook &book) override {
-        std::string timestamp = book.get_formatted_time_fast();
-        auto bid = book.get_best_bid_price();
-        auto ask = book.get_best_ask_price();
-        int trade_count = buy_qty_ + sell_qty_;
-
-        logger_->log(timestamp, bid, ask, position_, trade_count, pnl_);
+void ImbalanceStrat::log_stats(const Orderbook &book) {
+    if (!logger_) {
+        return;
     }
+    std::string timestamp = book.get_formatted_time_fast();
+    auto bid = book.get_best_bid_price();
+    auto ask = book.get_best_ask_price();
+    int trade_count = buy_qty_ + sell_qty_;
 
-public:
-    explicit ImbalanceStrat(DatabaseManager &db_manager, Orderbook *book)
-            : Strategy(db_manager, "imbalance_strat_log.csv", book) {}
-
-    void on_book_update() override {
-
-        auto imbalance = book_->imbalance_;
+    logger_->log(timestamp, bid, ask, position_, trade_count, pnl_);
+}
 
-        auto mid_price = book_->get_mid_price();
+void ImbalanceStrat::on_book_update() {
 
-        if (imbalance > 0  && position_ + 1 <= max_pos_) {
-            execute_trade(true, book_->get_best_ask_price(), 1);
-            trade_queue_.emplace(true, book_->get_best_ask_price());
+    auto imbalance = this->imbalance();
 
-        } else if (imbalance < 0 && position_ - 1 >= -max_pos_) {
-            execute_trade(false, book_->get_best_bid_price(), 1);
-            trade_queue_.emplace(false, book_->get_best_bid_price());
-        }
+    if (imbalance > params_.threshold_ && position_ + 1 <= max_pos_) {
+        execute_trade(true, book_->get_best_ask_price(), 1);
+        trade_queue_.emplace(true, book_->get_best_ask_price());
 
-        update_theo_values();
-        calculate_pnl();
+    } else if (imbalance < -params_.threshold_ && position_ - 1 >= -max_pos_) {
+        execute_trade(false, book_->get_best_bid_price(), 1);
+        trade_queue_.emplace(false, book_->get_best_bid_price());
     }
 
-    void execute_trade(bool is_buy, int32_t price, int size) override {
-        if (is_buy) {
-            position_ += size;
-            buy_qty_ += size;
-            real_total_buy_px_ += price * size;
-        } else {
-            position_ -= size;
-            sell_qty_ += size;
-            real_total_sell_px_ += price * size;
-        }
-        fees_ += FEES_PER_SIDE_;
-    }
-
-
-
-    void reset() override {
-        Strategy::reset();
-        imbalance_mean_ = 0.0;
-        imbalance_variance_ = 0.0;
-        update_count_ = 0;
+    update_theo_values();
+    calculate_pnl();
+}
+
+void ImbalanceStrat::execute_trade(bool is_buy, int32_t price, int size) {
+    if (is_buy) {
+        position_ += size;
+        buy_qty_ += size;
+        real_total_buy_px_ += price * size;
+    } else {
+        position_ -= size;
+        sell_qty_ += size;
+        real_total_sell_px_ += price * size;
     }
-};
\ No newline at end of file
+    fees_ += FEES_PER_SIDE_;
+}
+
+void ImbalanceStrat::reset() {
+    Strategy::reset();
+    imbalance_mean_ = 0.0;
+    imbalance_variance_ = 0.0;
+    update_count_ = 0;
+}
@@ -0,0 +1,201 @@
+#include "timer_wheel.h"
+#include <algorithm>
+
+namespace {
+
+// deadlines further out than this many ticks are parked in the top level until they get closer
+constexpr uint64_t MAX_SPAN = (1ULL << 60) - 1;
+
+}
+
+TimerWheel::TimerWheel(uint64_t tick_ns, uint64_t start_ns) : tick_ns_(tick_ns == 0 ? 1 : tick_ns) {
+    reset(start_ns);
+}
+
+void TimerWheel::reset(uint64_t start_ns) {
+    elapsed_ = start_ns / tick_ns_;
+    next_due_ = UINT64_MAX;
+    sequence_ = 0;
+    active_ = 0;
+    timers_.clear();
+    free_list_ = NULL_INDEX;
+    for (auto& level: slots_) {
+        level.fill(NULL_INDEX);
+    }
+    occupied_.fill(0);
+}
+
+uint32_t TimerWheel::acquire() {
+    if (free_list_ != NULL_INDEX) {
+        uint32_t index = free_list_;
+        free_list_ = timers_[index].next_;
+        return index;
+    }
+    timers_.push_back(Timer{});
+    timers_.back().generation_ = 1;
+    return static_cast<uint32_t>(timers_.size() - 1);
+}
+
+void TimerWheel::release(uint32_t index) {
+    Timer& timer = timers_[index];
+    ++timer.generation_; // stale ids no longer match
+    timer.next_ = free_list_;
+    free_list_ = index;
+}
+
+void TimerWheel::insert(uint32_t index) {
+    Timer& timer = timers_[index];
+    uint64_t when = std::max(to_tick(timer.deadline_), elapsed_);
+    if (when - elapsed_ > MAX_SPAN) {
+        when = elapsed_ + MAX_SPAN;
+    }
+
+    uint64_t significant = (elapsed_ ^ when) | (SLOTS - 1);
+    if (significant > MAX_SPAN) {
+        significant = MAX_SPAN;
+    }
+    uint32_t level = (63 - __builtin_clzll(significant)) / SLOT_BITS;
+    uint32_t slot = static_cast<uint32_t>(when >> (level * SLOT_BITS)) & (SLOTS - 1);
+
+    timer.next_ = slots_[level][slot];
+    slots_[level][slot] = index;
+    occupied_[level] |= 1ULL << slot;
+    // the slot comes up (and cascades) at its first tick, which may be before `when`
+    next_due_ = std::min<uint64_t>(next_due_, when & ~((1ULL << (level * SLOT_BITS)) - 1));
+}
+
+bool TimerWheel::next_expiration(uint64_t& start, uint32_t& level, uint32_t& slot) const {
+    // a lower level always expires first: its timers share more leading digits with elapsed_
+    for (uint32_t k = 0; k < LEVELS; ++k) {
+        uint64_t occupied = occupied_[k];
+        if (occupied == 0) {
+            continue;
+        }
+        uint32_t shift = k * SLOT_BITS;
+        uint64_t slot_range = 1ULL << shift;
+        uint64_t level_range = slot_range << SLOT_BITS;
+        uint32_t now_slot = static_cast<uint32_t>(elapsed_ >> shift) & (SLOTS - 1);
+
+        // first occupied slot at or after now_slot, wrapping around
+        uint64_t rotated = now_slot == 0 ? occupied : (occupied >> now_slot) | (occupied << (SLOTS - now_slot));
+        slot = (static_cast<uint32_t>(__builtin_ctzll(rotated)) + now_slot) & (SLOTS - 1);
+        level = k;
+
+        start = (elapsed_ & ~(level_range - 1)) + slot * slot_range;
+        if (start < (elapsed_ & ~(slot_range - 1))) {
+            start += level_range;
+        }
+        return true;
+    }
+    return false;
+}
+
+void TimerWheel::refresh_next_due() {
+    uint64_t start;
+    uint32_t level;
+    uint32_t slot;
+    next_due_ = next_expiration(start, level, slot) ? start : UINT64_MAX;
+}
+
+TimerWheel::TimerId TimerWheel::schedule_at(uint64_t deadline_ns, TimerCallback callback, void* context) {
+    return schedule_every(0, deadline_ns, callback, context);
+}
+
+TimerWheel::TimerId TimerWheel::schedule_every(uint64_t period_ns, uint64_t first_ns, TimerCallback callback,
+                                               void* context) {
+    uint32_t index = acquire();
+    Timer& timer = timers_[index];
+    timer.deadline_ = first_ns;
+    timer.period_ = period_ns;
+    timer.sequence_ = sequence_++;
+    timer.callback_ = callback;
+    timer.context_ = context;
+    timer.active_ = true;
+    ++active_;
+    insert(index);
+    return (static_cast<uint64_t>(timers_[index].generation_) << 32) | index;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    uint32_t index = static_cast<uint32_t>(id);
+    if (index >= timers_.size()) {
+        return false;
+    }
+    Timer& timer = timers_[index];
+    if (timer.generation_ != static_cast<uint32_t>(id >> 32) || !timer.active_) {
+        return false;
+    }
+    // unlinked lazily when its slot comes up
+    timer.active_ = false;
+    --active_;
+    return true;
+}
+
+void TimerWheel::advance(uint64_t now_ns) {
+    uint64_t now = now_ns / tick_ns_;
+    if (now < next_due_) {
+        // no slot starts at or before now, so the wheel can move up to it as after a full pass.
+        // timers scheduled in the past are then due at now whichever way advance() returned
+        elapsed_ = std::max(elapsed_, now);
+        return;
+    }
+
+    uint64_t start;
+    uint32_t level;
+    uint32_t slot;
+    while (next_expiration(start, level, slot) && start <= now) {
+        elapsed_ = start;
+        uint32_t index = slots_[level][slot];
+        slots_[level][slot] = NULL_INDEX;
+        occupied_[level] &= ~(1ULL << slot);
+
+        if (level != 0) {
+            // cascade: everything in a higher slot moves down relative to the new position
+            while (index != NULL_INDEX) {
+                uint32_t next = timers_[index].next_;
+                timers_[index].active_ ? insert(index) : release(index);
+                index = next;
+            }
+            continue;
+        }
+
+        firing_.clear();
+        for (; index != NULL_INDEX; index = timers_[index].next_) {
+            firing_.push_back(index);
+        }
+        std::sort(firing_.begin(), firing_.end(), [this](uint32_t a, uint32_t b) {
+            const Timer& lhs = timers_[a];
+            const Timer& rhs = timers_[b];
+            return lhs.deadline_ != rhs.deadline_ ? lhs.deadline_ < rhs.deadline_ : lhs.sequence_ < rhs.sequence_;
+        });
+
+        for (uint32_t fire: firing_) {
+            if (!timers_[fire].active_) {
+                release(fire);
+                continue;
+            }
+            // the callback may grow timers_, nothing is held across it
+            timers_[fire].callback_(now_ns, timers_[fire].context_);
+
+            Timer& timer = timers_[fire];
+            uint64_t missed = now_ns >= timer.deadline_ && timer.period_ != 0
+                              ? (now_ns - timer.deadline_) / timer.period_ : 0;
+            uint64_t next_deadline;
+            if (!timer.active_) {
+                release(fire);
+            } else if (timer.period_ == 0 ||
+                       __builtin_mul_overflow(missed + 1, timer.period_, &next_deadline) ||
+                       __builtin_add_overflow(timer.deadline_, next_deadline, &next_deadline)) {
+                timer.active_ = false;
+                --active_;
+                release(fire);
+            } else {
+                timer.deadline_ = next_deadline;
+                insert(fire);
+            }
+        }
+    }
+
+    elapsed_ = std::max(elapsed_, now);
+    refresh_next_due();
+}